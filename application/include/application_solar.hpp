@@ -8,7 +8,19 @@
 #include "geometry_node.hpp"
 #include "camera_node.hpp"
 #include "point_light_node.hpp"
+#include "node_pool.hpp"
 #include "texture_loader.hpp"
+#include "post_process.hpp"
+#include "nbody.hpp"
+#include "scene_file.hpp"
+#include "texture_stream.hpp"
+#include "mesh_registry.hpp"
+#include "render_queue.hpp"
+#include "dynamic_resolution.hpp"
+#include "frame_pipeline.hpp"
+#include "job_system.hpp"
+
+#include <map>
 
 // gpu representation of model
 class ApplicationSolar : public Application {
@@ -24,49 +36,82 @@ public:
     void mouseCallback(double pos_x, double pos_y);
     //handle resizing
     void resizeCallback(unsigned width, unsigned height);
+    // move the camera by the input collected since the last frame and apply the last window size
+    void applyInput();
+    // view of all camera programs, and their projection if it changed
+    void uploadCamera(glm::fmat4 const& view_transform, bool projection) const;
+    // projection and targets for a new window size
+    void resize(unsigned width, unsigned height);
 
-    // draw all objects
+    // add streamed bodies and textures
+    void update();
+    // submit the prepared frame while the worker prepares the next one
     void render() const;
-    // draw single planet
-    void renderPlanet(std::shared_ptr<GeometryNode> planet)const;
+    // record all planets, one multi draw per texture
+    void renderPlanets() const;
+    // record the planets without shading, only filling the depth buffer
+    void renderDepthPrepass() const;
     void renderStars()const;
+    // upload the lights of the submitted frame
     void renderLightNodes()const;
     void renderOrbits() const;
+    // record the light accumulation of the deferred path
+    void renderLighting() const;
+    // program drawing the planets in the current mode
+    std::string const& getPlanetProgram() const;
     void renderSkybox() const;
 
-    // =====================================================
-    // Assignment 5
-    void renderFullscreenquad() const;
-    // =====================================================
-
 protected:
+    // register the kinds of draws recorded by the render functions
+    void initializeRenderQueue();
+    // print bind counts when they differ from the last frame
+    void reportStateChanges() const;
+    // read the fragment count of the last frame, printed once a second if enabled
+    void reportOverdraw() const;
+    // print render scale and frame time once a second while it is adjusted
+    void reportResolution() const;
+
     void initializeShaderPrograms();
     void initializeGeometry();
 
     // =====================================================
     // Assignment 5
-    // initialize the Frame Buffer
-    void initializeFrameBuffer(int width, int height);
-    
-    // fullscreen quad
-    void initializeFullscreenQuad();
+    // initialize the Frame Buffer, reallocated only if the size changed
+    void initializeFrameBuffer(unsigned width, unsigned height);
+    // print number and memory of live render targets
+    void reportRenderTargets() const;
 
-    model_object fullscreen_quad;
+    // owns the scene framebuffer and its attachments
+    RenderTargetPool render_targets;
+    render_target* scene_target;
+    // albedo and normal with depth, only allocated while deferred shading is on
+    render_target* gbuffer_target;
+    // scene with several samples per pixel, resolved into scene_target before post processing
+    render_target* msaa_target;
 
-    framebuffer_object framebuffer;
+    // effects applied to the framebuffer before it is shown
+    PostProcessChain post_process;
+    // regroup passes, compile missing programs and upload parameters
+    void updatePostProcessing();
+    // switch single effect of the chain on or off
+    void togglePostEffect(std::string const& name);
     // =====================================================
 
     // update uniform values
     void uploadUniforms();
     // upload projection matrix
-    void uploadProjection(std::string shader_name);
+    void uploadProjection(std::string const& shader_name);
     // upload view matrix
-    void uploadView(std::string shader_name);
+    void uploadView(std::string const& shader_name);
 
     // create Scene Graph
     void initializeSolarSystem();
-    // create single sun
-    void makeSun(
+    // add the next chunk of bodies once the scene file is read
+    void streamScene();
+    // create holder and geometry of a body from the scene file
+    void makeBody(body_description const& body);
+    // create single sun, returns the holder
+    std::shared_ptr<Node> makeSun(
         std::string const& name,
         std::shared_ptr<Node> const& parent,
         float distance,
@@ -77,25 +122,140 @@ protected:
         glm::fvec3 light_color, std::string texture,
         int index
         );
-    // create single planet
-    void makePlanet(std::string const& name, std::shared_ptr<Node> const& parent, float distance, float size, float speed, glm::fvec3 color, std::string texture, int index);
-    // initialize texture of single planet / sun
+    // create single planet, returns the holder
+    // orbit angles in degrees
+    std::shared_ptr<Node> makePlanet(std::string const& name, std::shared_ptr<Node> const& parent, float size, float speed, float distance, glm::fvec3 color, std::string texture, int index,
+                    float eccentricity = 0.0f, float inclination = 0.0f, float ascending_node = 0.0f, float periapsis = 0.0f);
+    // initialize texture of single planet / sun, shared per file and loaded in the background
     void makeTexture(std::shared_ptr<GeometryNode> const& object);
+    // upload textures decoded since the last frame
+    void streamTextures();
     // create stars
     void initializeStars();
-    // init orbits
+    // start gravitational simulation from the current state of the orbits
+    void startNBody();
+    // init orbits, elements of all planets in a texture buffer
     void initializeOrbits();
+    // append elements of a new planet
+    void addOrbit(std::shared_ptr<GeometryNode> const& planet);
+    // upload texels after planets were added
+    void uploadOrbitElements();
+    // upload segment bounds and viewport height for adaptive ring tessellation
+    void uploadOrbitTessellation();
     // init Skybox
     void initializeSkyBox();
 
+    // all meshes in shared buffers, planets are drawn from per frame commands
+    mutable MeshRegistry meshes_;
+    std::size_t sphere_mesh_;
+    std::size_t skybox_mesh_;
     // cpu representation of model
-    model_object planet_object;
     model_object star_object;
     model_object orbit_object;
-    model_object skybox_object;
+    // orbital elements indexed by instance id
+    texture_object orbit_elements;
+    GLsizei orbit_count;
+    // elements of all planets, positions are updated while rendering
+    mutable kepler::orbit_batch orbit_batch_;
+    // center of each orbit in world space
+    mutable std::vector<glm::fvec3> orbit_centers_;
+    // planet index of the body each holder orbits, -1 for the root
+    std::vector<int> orbit_parents_;
+    // planet index of each holder
+    std::map<Node*, int> orbit_indices_;
+    // per planet position and spin, world and normal matrices
+    mutable std::vector<glm::fmat4> planet_placements_;
+    mutable std::vector<glm::fmat4> planet_models_;
+    mutable std::vector<glm::fmat4> planet_normals_;
+    // per planet draw data read by the planet shader, nine texels each, only the ambient is kept here
+    GLuint body_data_buffer_;
+    texture_object body_data_;
+    mutable std::vector<glm::fvec4> body_texels_;
+    // planet indices sorted by texture and the commands drawing them
+    mutable std::vector<GLuint> planet_textures_;
+    mutable std::vector<std::size_t> draw_order_;
+    // view space distance of each planet
+    mutable std::vector<float> planet_depths_;
+    // commands of planets sharing a texture
+    struct draw_group {
+        std::size_t first;
+        std::size_t count;
+        GLuint texture;
+        // distance of the nearest planet
+        float depth;
+    };
+    // everything the gl side needs to draw a frame, filled without gl calls
+    struct frame_packet {
+        // camera and time the frame is prepared for
+        glm::fmat4 view_transform;
+        double time;
+        // state revision the frame is prepared from
+        std::size_t revision;
+        // per planet draw data, the commands drawing them grouped by texture
+        std::vector<glm::fvec4> body_texels;
+        std::vector<draw_elements_indirect_command> draw_commands;
+        std::vector<draw_group> planet_groups;
+        // ring texels with their current centers, empty while simulating
+        std::vector<glm::fvec4> orbit_texels;
+        // world position, color and intensity of each light
+        std::vector<glm::fvec3> light_positions;
+        std::vector<glm::fvec3> light_colors;
+        std::vector<float> light_intensities;
+    };
+    // runs as a job, must not touch gl or anything the main thread changes before waiting
+    void prepareFrame(std::size_t slot) const;
+    // propagate orbits or step the simulation, then update transforms of all bodies
+    void updateOrbits(frame_packet& frame) const;
+    // planet matrices and their commands, nearest first within each texture
+    void preparePlanets(frame_packet& frame) const;
+    void gatherLights(frame_packet& frame) const;
+    // upload the draw data of the frame about to be submitted
+    void uploadFrame(frame_packet const& frame) const;
+
+    // draws of a frame sorted by state, binds skipped if already current
+    mutable RenderQueue render_queue_;
+    mutable StateCache state_;
+    std::size_t skybox_pass_;
+    std::size_t star_pass_;
+    std::size_t planet_pass_;
+    std::size_t orbit_pass_;
+    std::size_t lighting_pass_;
+    std::size_t depth_pass_;
+    // samples passed while shading planets, the query of the last frame is read
+    GLuint overdraw_queries_[2];
+    mutable std::size_t overdraw_frame_;
+    mutable GLuint shaded_fragments_;
+    mutable double last_overdraw_report_;
+    // render scale follows the gpu time, the scene fills the lower left part of its targets
+    mutable DynamicResolution resolution_;
+    mutable glm::uvec2 render_size_;
+    mutable double last_resolution_report_;
+    // bind counts of the last frame
+    mutable std::size_t issued_state_changes_;
+    mutable std::size_t skipped_state_changes_;
+    // planet index of each ring and its texels
+    std::vector<std::size_t> orbit_rings_;
+    mutable std::vector<glm::fvec4> orbit_texels_;
+    // bodies in the order of the planet list
+    mutable NBodySimulation nbody_;
+    bool nbody_mode = false;
+    // color format of the scene, float formats keep values above 1 for the tone mapping
+    GLenum scene_format = GL_RGB8;
+    // samples per pixel of the forward path, 1 renders into scene_target directly
+    GLsizei msaa_samples = 1;
+    // planets written to the g-buffer and lit in one screen pass
+    bool deferred_mode = false;
+    // depth of the planets is laid down first, so hidden fragments are never shaded
+    bool depth_prepass = false;
+    bool overdraw_report = false;
+    // no attributes, the lighting pass generates its triangle
+    model_object lighting_object;
+    mutable double last_update_time_ = 0.0;
 
     // camera transform matrix
     glm::fmat4 m_view_transform;
+    // view matrix in the camera programs, from the frame submitted last
+    mutable glm::fmat4 uploaded_view_transform_;
     // camera projection matrix
     glm::fmat4 m_view_projection;
     bool cellShading_Mode;
@@ -106,16 +266,48 @@ protected:
 
 private:
     SceneGraph solarSystem_;
+    // storage of all scene graph nodes, by type
+    NodePool<Node> node_pool_;
+    NodePool<GeometryNode> geometry_pool_;
+    NodePool<PointLightNode> light_pool_;
+    NodePool<CameraNode> camera_pool_;
+
+    // scene file read by a job, then streamed into the graph
+    JobCounter scene_loading_;
+    bool scene_pending_ = false;
+    scene_description loaded_scene_;
+    scene_description scene_;
+    std::size_t streamed_bodies_ = 0;
+    // holders by body name, to find the parents of later bodies
+    std::map<std::string, std::shared_ptr<Node>> body_holders_;
+    // decoded images waiting for upload, textures by file name
+    TextureStream texture_stream_;
+    std::map<std::string, texture_object> textures_;
     std::vector<float> stars_;
-    
-    // Set a boolean for action for the postprocessing
-    bool horizontal_mirroring = false;
-    bool vertical_mirroring = false;
-    bool greyscale_mode = false;
-    bool blur_mode = false;
+
     bool moving_time = true;
+    // input since the last frame, in camera space and degrees around the y and x axis
+    glm::fvec3 pending_translation_{0.0f};
+    glm::fvec2 pending_rotation_{0.0f};
+    // camera placement requested by input, m_view_transform follows it
+    glm::fmat4 target_view_transform_;
+    bool camera_smoothing_ = true;
+    double last_camera_time_ = 0.0;
+    // last size reported by the window, zero if unchanged
+    glm::uvec2 pending_size_{0u};
     unsigned img_width;
     unsigned img_height;
+
+    // frames prepared alternately, one is submitted while the worker fills the other
+    mutable frame_packet frames_[2];
+    mutable std::size_t submitted_slot_ = 0;
+    mutable bool frame_prepared_ = false;
+    // counts changes of state read while preparing, the drawn frame is outdated until it includes all
+    std::size_t state_revision_ = 0;
+    mutable std::size_t drawn_revision_ = 0;
+    mutable glm::fmat4 drawn_view_transform_;
+    // destroyed first, so a running preparation finishes before anything it reads
+    mutable FramePipeline frame_pipeline_;
 };
 
 #endif
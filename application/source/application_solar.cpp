@@ -4,6 +4,7 @@
 #include "utils.hpp"
 #include "shader_loader.hpp"
 #include "model_loader.hpp"
+#include "transform_batch.hpp"
 
 #include <glbinding/gl/gl.h>
 
@@ -16,41 +17,126 @@ using namespace gl;
 
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/matrix_inverse.hpp>
+#include <glm/gtc/quaternion.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
 #include <stdio.h>
+#include <algorithm>
 #include <iostream>
 #include <random>
+#include <chrono>
+#include <cmath>
+#include <map>
+
+// bounds of the segments per orbit ring, chosen by projected size
+static const unsigned min_orbit_segments = 16;
+static const unsigned max_orbit_segments = 512;
+// longest integration step of the n-body simulation in seconds
+static const float max_nbody_step = 0.005f;
+// scene in the scenes directory, json or binary
+static const char* const scene_file_name = "solar_system.json";
+// bodies added to the scene graph per frame while streaming
+static const std::size_t bodies_per_frame = 256;
+// render queue layers, planets front to back first, the skybox last at the far plane
+// deferred lighting before anything that is not in the g-buffer
+static const unsigned planet_layer = 0;
+static const unsigned lighting_layer = 1;
+static const unsigned opaque_layer = 2;
+static const unsigned background_layer = 3;
+// size of the light arrays in deferred_lighting.frag
+static const std::size_t max_deferred_lights = 8;
+// render scale bounds and the gpu time per frame they are adjusted to, in milliseconds
+static const float min_render_scale = 0.5f;
+static const float max_render_scale = 1.0f;
+static const double frame_budget = 1000.0 / 60.0;
+// camera movement per key event and degrees per pixel of mouse movement
+static const float camera_step = 0.1f;
+static const float mouse_sensitivity = 0.05f;
+// share of the remaining distance the smoothed camera covers per second is 1 - exp(-rate)
+static const float camera_follow_rate = 20.0f;
+// programs drawing in camera space, updated together when the camera moves
+static std::string const camera_programs[] = {"planet", "planet_gbuffer", "planet_depth", "star", "orbits", "skybox"};
+// planets per job when their matrices and draw data are computed, smaller scenes stay on one thread
+static const std::size_t planets_per_job = 2048;
+// written when job tracing is switched off, open in chrome://tracing
+static const char* const job_trace_file_name = "job_trace.json";
+// depth of scene and g-buffer must match to copy it between them
+static const GLenum scene_depth_format = GL_DEPTH_COMPONENT24;
 
 ApplicationSolar::ApplicationSolar(std::string const& resource_path)
     :Application{resource_path}
-    ,planet_object{}
+    ,meshes_{}
+    ,sphere_mesh_{0}
+    ,skybox_mesh_{0}
     ,star_object{}
     ,orbit_object{}
+    ,orbit_elements{}
+    ,orbit_count{0}
+    ,body_data_buffer_{0}
+    ,body_data_{}
+    ,render_queue_{}
+    ,state_{}
+    ,skybox_pass_{0}
+    ,star_pass_{0}
+    ,planet_pass_{0}
+    ,orbit_pass_{0}
+    ,lighting_pass_{0}
+    ,depth_pass_{0}
+    ,overdraw_queries_{0, 0}
+    ,overdraw_frame_{0}
+    ,shaded_fragments_{0}
+    ,last_overdraw_report_{0.0}
+    ,resolution_{min_render_scale, max_render_scale, frame_budget}
+    ,render_size_{initial_resolution}
+    ,last_resolution_report_{0.0}
+    ,issued_state_changes_{0}
+    ,skipped_state_changes_{0}
     ,m_view_transform{glm::translate(glm::fmat4{}, glm::fvec3{0.0f, 0.0f, 4.0f})}
     ,m_view_projection{utils::calculate_projection_matrix(initial_aspect_ratio)}
     //,cellShading_Mode{false}
-    ,skybox_object{}
-    ,fullscreen_quad{} // Assignment 5
-    ,framebuffer{} // Assignment 5
+    ,render_targets{} // Assignment 5
+    ,scene_target{nullptr}
+    ,gbuffer_target{nullptr}
+    ,msaa_target{nullptr}
+    ,post_process{resource_path + "shaders/"}
+    ,img_width{initial_resolution.x}
+    ,img_height{initial_resolution.y}
+    ,frame_pipeline_{[this](std::size_t slot) { prepareFrame(slot); }}
 {
+    target_view_transform_ = m_view_transform;
     initializeGeometry();
     initializeShaderPrograms();
     initializeSolarSystem();
     initializeStars();
     initializeSkyBox();
     initializeOrbits();
+    initializeRenderQueue();
     // =====================================================
     // Assignment 5
     initializeFrameBuffer(initial_resolution.x, initial_resolution.y);
-    initializeFullscreenQuad();
     // =====================================================
 }
 
 ApplicationSolar::~ApplicationSolar() {
-    glDeleteBuffers(1, &planet_object.vertex_BO);
-    glDeleteBuffers(1, &planet_object.element_BO);
-    glDeleteVertexArrays(1, &planet_object.vertex_AO);
+    if (scene_pending_) {
+        // the loading job writes into this object, whether it failed does not matter anymore
+        try {
+            JobSystem::shared().wait(scene_loading_);
+        }
+        catch (...) {
+        }
+    }
+    glDeleteTextures(1, &body_data_.handle);
+    glDeleteBuffers(1, &body_data_buffer_);
+
+    glDeleteTextures(1, &orbit_elements.handle);
+    for (auto const& texture : textures_) {
+        glDeleteTextures(1, &texture.second.handle);
+    }
+    glDeleteBuffers(1, &orbit_object.vertex_BO);
+    glDeleteVertexArrays(1, &orbit_object.vertex_AO);
+    glDeleteVertexArrays(1, &lighting_object.vertex_AO);
+    glDeleteQueries(2, overdraw_queries_);
 
     /*
     // =====================================================
@@ -58,18 +144,6 @@ ApplicationSolar::~ApplicationSolar() {
     glDeleteBuffers(1, &star_object.vertex_BO);
     glDeleteBuffers(1, &star_object.element_BO);
     glDeleteVertexArrays(1, &star_object.vertex_AO);
-
-    glDeleteBuffers(1, &orbit_object.vertex_BO);
-    glDeleteBuffers(1, &orbit_object.element_BO);
-    glDeleteVertexArrays(1, &orbit_object.vertex_AO);
-
-    glDeleteBuffers(1, &skybox_object.vertex_BO);
-    glDeleteBuffers(1, &skybox_object.element_BO);
-    glDeleteVertexArrays(1, &skybox_object.vertex_AO);
-
-    glDeleteBuffers(1, &fullscreen_quad.vertex_BO);
-    glDeleteBuffers(1, &fullscreen_quad.element_BO);
-    glDeleteVertexArrays(1, &fullscreen_quad.vertex_AO);
     // =====================================================
     */
 
@@ -77,105 +151,190 @@ ApplicationSolar::~ApplicationSolar() {
 
 void ApplicationSolar::initializeSolarSystem(){
     // root node
-    Node root_node = Node();
-    std::shared_ptr<Node> root_node_pointer = std::make_shared<Node>(root_node);
+    std::shared_ptr<Node> root_node_pointer = node_pool_.create();
 
     // create scene graph
     solarSystem_ = SceneGraph("Solar System", root_node_pointer);
 
-    // sun
-    makeSun("sun", root_node_pointer, 0.5f, 0.0f, 0.0f, glm::fvec3{1.0f, 1.0f, 0.2f}, 1.0f, glm::fvec3{255, 255, 150},"sun.png", 1);
+    // camera
+    std::shared_ptr<CameraNode> camera_pointer = camera_pool_.create("camera", root_node_pointer, glm::fmat4(1));
+    solarSystem_.addNode(root_node_pointer, camera_pointer);
+
+    // bodies are read by a job and added a chunk per frame by streamScene
+    scene_pending_ = true;
+    JobSystem::shared().run("load scene", [this]() {
+        loaded_scene_ = scene_file::load(m_resource_path + "scenes/" + scene_file_name);
+    }, &scene_loading_);
+}
 
-    // planets
-    makePlanet("mercury", root_node_pointer, 0.09f, 0.5f, 1.0f, glm::fvec3{0.59f, 0.59f, 0.62f},"mercury.png", 2);
-    makePlanet("venus", root_node_pointer, 0.2f, 0.4f, 1.5f, glm::fvec3{1.0f, 1.0f, 0.75f},"venus.png", 3);
-    makePlanet("earth", root_node_pointer, 0.2f, 0.3f, 2.5f, glm::fvec3{0.0f, 0.52f, 0.85f},"earth.png", 4);
-    makePlanet("mars", root_node_pointer, 0.1f, 0.2f, 3.5f, glm::fvec3{0.63f, 0.24f, 0.18f},"mars.png", 5);
-    makePlanet("jupiter", root_node_pointer, 0.4f, 0.09f, 5.0f, glm::fvec3{1.0f, 0.55f, 0.24f},"jupiter.png", 6);
-    makePlanet("saturn", root_node_pointer, 0.4f, 0.10f, 7.0f, glm::fvec3{0.9f, 0.75f, 0.54f},"saturn.png", 7);
-    makePlanet("uranus", root_node_pointer, 0.3f, 0.05f, 9.0f, glm::fvec3{0.69f, 0.93f, 0.93f},"uranus.png", 8);
-    makePlanet("neptune", root_node_pointer, 0.3f, 0.04f, 10.0f, glm::fvec3{0.69f, 0.93f, 0.93f},"neptune.png", 9);
-    makePlanet("pluto", root_node_pointer, 0.04f, 0.06f, 10.5f, glm::fvec3{65, 105, 225},"pluto.png", 10);
+void ApplicationSolar::update() {
+    // streaming and input change what the worker reads
+    frame_pipeline_.wait();
+    applyInput();
+    streamScene();
+    streamTextures();
+    // moving bodies and loading change the image without any input
+    // the frame drawn next was prepared a frame earlier, so drawing goes on until one includes the latest change
+    if (moving_time || scene_pending_ || streamed_bodies_ < scene_.bodies.size()
+        || texture_stream_.getPendingCount() > 0
+        || drawn_revision_ != state_revision_ || drawn_view_transform_ != m_view_transform) {
+        m_frame_pacer.requestRedraw();
+    }
+}
 
-    // moon
-    std::shared_ptr<Node> earthHolderPtr = root_node_pointer->getChild("earth holder");
-    makePlanet("moon", earthHolderPtr, 1.0f, 1.3f, 0.6f, glm::fvec3{0.83f, 0.83f, 0.83f},"moon.png", 11);
+void ApplicationSolar::streamScene() {
+    if (scene_pending_) {
+        if (!scene_loading_.done()) {
+            return;
+        }
+        scene_pending_ = false;
+        try {
+            // rethrows what the loading job threw
+            JobSystem::shared().wait(scene_loading_);
+            scene_ = std::move(loaded_scene_);
+        }
+        catch (std::exception& error) {
+            std::cerr << error.what() << std::endl;
+        }
+        streamed_bodies_ = 0;
+    }
+    if (streamed_bodies_ == scene_.bodies.size()) {
+        return;
+    }
 
-    // camera
-    CameraNode camera = CameraNode("camera", root_node_pointer, glm::fmat4(1));
-    std::shared_ptr<CameraNode> camera_pointer = std::make_shared<CameraNode>(camera);
-    root_node_pointer->addChild(camera_pointer);
+    std::size_t end = std::min(streamed_bodies_ + bodies_per_frame, scene_.bodies.size());
+    for (; streamed_bodies_ < end; ++streamed_bodies_) {
+        makeBody(scene_.bodies[streamed_bodies_]);
+    }
+    ++state_revision_;
+    uploadOrbitElements();
+    // the simulation is restarted to include the new bodies
+    if (nbody_mode) {
+        startNBody();
+    }
 
-    std::cout << solarSystem_.printGraph() << std::endl;
+    if (streamed_bodies_ == scene_.bodies.size()) {
+        std::cout << solarSystem_.printGraph() << std::endl;
+        // descriptions are not needed anymore
+        scene_ = scene_description{};
+        streamed_bodies_ = 0;
+        body_holders_.clear();
+    }
 }
 
-void ApplicationSolar::makeSun(std::string const& name, std::shared_ptr<Node> const& parent, float size, float speed, float distance, glm::fvec3 color, float light_intensity, glm::fvec3 light_color, std::string texture, int index){
-    // set up local transform matrix
-    glm::fmat4 localTransform = parent->getWorldTransform();
-    localTransform = glm::translate(localTransform, glm::fvec3{0.0f, 0.0f, distance});
-    localTransform = glm::rotate(localTransform, float(glfwGetTime()) * speed, glm::fvec3{0.0f, 1.0f, 0.0f});
-    localTransform = glm::scale(localTransform, glm::fvec3{size, size, size});
+void ApplicationSolar::makeBody(body_description const& body) {
+    std::shared_ptr<Node> parent = body.parent.empty() ? solarSystem_.getRoot() : body_holders_.at(body.parent);
+    // texture units and legacy indices count from 1
+    int index = int(solarSystem_.getPlanets().size()) + 1;
+    std::shared_ptr<Node> holder{};
+    if (body.light) {
+        holder = makeSun(body.name, parent, body.size, body.speed, body.distance, body.color, body.light_intensity, body.light_color, body.texture, index);
+    }
+    else {
+        holder = makePlanet(body.name, parent, body.size, body.speed, body.distance, body.color, body.texture, index,
+                            body.eccentricity, body.inclination, body.ascending_node, body.periapsis);
+    }
+    body_holders_[body.name] = holder;
+}
+
+std::shared_ptr<Node> ApplicationSolar::makeSun(std::string const& name, std::shared_ptr<Node> const& parent, float size, float speed, float distance, glm::fvec3 color, float light_intensity, glm::fvec3 light_color, std::string texture, int index){
+    // set up local transform matrix, position and spin are applied by updateOrbits
+    glm::fmat4 localTransform = glm::scale(glm::fmat4{}, glm::fvec3{size, size, size});
 
     // create holder node
-    PointLightNode sun_light = PointLightNode(name + " light", parent, localTransform, light_intensity, light_color);
-    std::shared_ptr<PointLightNode> sun_light_pointer = std::make_shared<PointLightNode>(sun_light);
-    parent->addChild(sun_light_pointer);
+    std::shared_ptr<PointLightNode> sun_light_pointer = light_pool_.create(name + " light", parent, localTransform, light_intensity, light_color);
+    solarSystem_.addNode(parent, sun_light_pointer);
 
     // create geometry node
-    GeometryNode sun_geometry = GeometryNode(name + " geometry", sun_light_pointer, glm::fmat4(1), size, speed, distance, color, texture, index);
-    std::shared_ptr<GeometryNode> sun_geometry_pointer = std::make_shared<GeometryNode>(sun_geometry);
-    sun_light_pointer->addChild(sun_geometry_pointer);
+    std::shared_ptr<GeometryNode> sun_geometry_pointer = geometry_pool_.create(name + " geometry", sun_light_pointer, glm::fmat4(1), size, speed, distance, color, texture, index);
+    solarSystem_.addNode(sun_light_pointer, sun_geometry_pointer);
+
+    orbital_elements orbit{};
+    orbit.semi_major_axis = distance;
+    orbit.mean_motion = speed;
+    sun_geometry_pointer->setOrbit(orbit);
 
     solarSystem_.addPlanet(sun_geometry_pointer);
     solarSystem_.addLightNode(sun_light_pointer);
 
     makeTexture(sun_geometry_pointer);
+    addOrbit(sun_geometry_pointer);
+    return sun_light_pointer;
 }
 
-void ApplicationSolar::makePlanet(std::string const& name, std::shared_ptr<Node> const& parent, float size, float speed, float distance, glm::fvec3 color, std::string texture, int index){
-    // set up local transform matrix
-    glm::fmat4 localTransform = parent->getWorldTransform();
-    localTransform = glm::translate(localTransform, glm::fvec3{0.0f, 0.0f, distance});
-    localTransform = glm::rotate(localTransform, float(glfwGetTime()) * speed, glm::fvec3{0.0f, 1.0f, 0.0f});
-    localTransform = glm::scale(localTransform, glm::fvec3{size, size, size});
+std::shared_ptr<Node> ApplicationSolar::makePlanet(std::string const& name, std::shared_ptr<Node> const& parent, float size, float speed, float distance, glm::fvec3 color, std::string texture, int index,
+                                  float eccentricity, float inclination, float ascending_node, float periapsis){
+    // set up local transform matrix, position and spin are applied by updateOrbits
+    glm::fmat4 localTransform = glm::scale(glm::fmat4{}, glm::fvec3{size, size, size});
 
     // create holder node
-    Node planet_holder = Node(name + " holder", parent, localTransform);
-    std::shared_ptr<Node> planet_holder_pointer = std::make_shared<Node>(planet_holder);
-    parent->addChild(planet_holder_pointer);
+    std::shared_ptr<Node> planet_holder_pointer = node_pool_.create(name + " holder", parent, localTransform);
+    solarSystem_.addNode(parent, planet_holder_pointer);
 
     // create geometry node
-    GeometryNode planet = GeometryNode(name, planet_holder_pointer, glm::fmat4(1), size, speed, distance, color, texture, index);
-    std::shared_ptr<GeometryNode> planet_pointer = std::make_shared<GeometryNode>(planet);
-    planet_holder_pointer->addChild(planet_pointer);
+    std::shared_ptr<GeometryNode> planet_pointer = geometry_pool_.create(name, planet_holder_pointer, glm::fmat4(1), size, speed, distance, color, texture, index);
+    solarSystem_.addNode(planet_holder_pointer, planet_pointer);
+
+    // distance is the semi-major axis, speed the mean motion
+    orbital_elements orbit{};
+    orbit.semi_major_axis = distance;
+    orbit.eccentricity = eccentricity;
+    orbit.inclination = glm::radians(inclination);
+    orbit.ascending_node = glm::radians(ascending_node);
+    orbit.periapsis_argument = glm::radians(periapsis);
+    orbit.mean_motion = speed;
+    planet_pointer->setOrbit(orbit);
 
     solarSystem_.addPlanet(planet_pointer);
     makeTexture(planet_pointer);
+    addOrbit(planet_pointer);
+    return planet_holder_pointer;
 }
 
 void ApplicationSolar::makeTexture(std::shared_ptr<GeometryNode> const& object){
-    // load texture
-    pixel_data planetTexture = texture_loader::file(m_resource_path + "textures/" + object->getTexture());
-    // select active texture unit
-    glActiveTexture(GL_TEXTURE0 + object->getIndex());
-
-    // create texture object
-    texture_object tex;
-    tex.target = GL_TEXTURE_2D;
-    // generate texture names
-    glGenTextures(1, &tex.handle);
-    glBindTexture(tex.target, tex.handle);
-    object->setTextureObject(tex);
-
-    // define texture sampling parameters
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    // textures are shared by all bodies using the same file, decoded once in the background
+    auto texture = textures_.find(object->getTexture());
+    if (texture != textures_.end()) {
+        object->setTextureObject(texture->second);
+        return;
+    }
+    // placeholder until streamTextures uploads the image
+    textures_[object->getTexture()] = texture_object{};
+    texture_stream_.request(m_resource_path + "textures/" + object->getTexture());
+}
 
-    // define texture data and format
-    glTexImage2D(GL_TEXTURE_2D, 0, planetTexture.channels, planetTexture.width, planetTexture.height, 0, planetTexture.channels, planetTexture.channel_type, planetTexture.ptr());
+void ApplicationSolar::streamTextures(){
+    std::string texture_path = m_resource_path + "textures/";
+    std::string file_name{};
+    pixel_data planetTexture{};
+    while (texture_stream_.poll(file_name, planetTexture)) {
+        std::string name = file_name.substr(texture_path.size());
+
+        // create texture object
+        texture_object& tex = textures_[name];
+        tex.target = GL_TEXTURE_2D;
+        // generate texture names
+        glGenTextures(1, &tex.handle);
+        glBindTexture(tex.target, tex.handle);
+
+        // define texture sampling parameters
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        // define texture data and format
+        glTexImage2D(GL_TEXTURE_2D, 0, planetTexture.channels, GLsizei(planetTexture.width), GLsizei(planetTexture.height), 0, planetTexture.channels, planetTexture.channel_type, planetTexture.ptr());
+
+        // hand the texture to all bodies created while it was loading
+        for (auto const& planet : solarSystem_.getPlanets()) {
+            if (planet->getTexture() == name) {
+                planet->setTextureObject(tex);
+            }
+        }
+        ++state_revision_;
+    }
 }
 
 void ApplicationSolar::initializeSkyBox() {
@@ -273,179 +432,138 @@ void ApplicationSolar::initializeStars(){
 
 void ApplicationSolar::initializeOrbits()
 {
-    std::vector<float> orbits;
-    int points_in_circle = 360;
+    // texels are filled by addOrbit as bodies are streamed in
+    glGenBuffers(1, &orbit_object.vertex_BO);
+    glBindBuffer(GL_TEXTURE_BUFFER, orbit_object.vertex_BO);
+    glBufferData(GL_TEXTURE_BUFFER, 0, NULL, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
 
-    for (int i = 0; i < points_in_circle; ++i) {
-        GLfloat x = cos(i * 3.14159265358979323846 / 180); //calculating points on a circle in right order
-        GLfloat y = 0;
-        GLfloat z = sin(i * 3.14159265358979323846 / 180);
-        orbits.push_back(x);
-        orbits.push_back(y);
-        orbits.push_back(z);
-    }
+    orbit_elements.target = GL_TEXTURE_BUFFER;
+    glGenTextures(1, &orbit_elements.handle);
+    glBindTexture(GL_TEXTURE_BUFFER, orbit_elements.handle);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, orbit_object.vertex_BO);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
 
-    //Same as in draw stars
+    // no attributes, but core profile needs a vertex array to draw
     glGenVertexArrays(1, &orbit_object.vertex_AO);
-    glBindVertexArray(orbit_object.vertex_AO);
-
-    glGenBuffers(1, &orbit_object.vertex_BO);
-    glBindBuffer(GL_ARRAY_BUFFER, orbit_object.vertex_BO);
-    glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(sizeof(float) * orbits.size()), orbits.data(), GL_STATIC_DRAW);
+    glGenVertexArrays(1, &lighting_object.vertex_AO);
+
+    // matrices of the planets, rewritten every frame
+    glGenBuffers(1, &body_data_buffer_);
+    glBindBuffer(GL_TEXTURE_BUFFER, body_data_buffer_);
+    glBufferData(GL_TEXTURE_BUFFER, 0, NULL, GL_STREAM_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    body_data_.target = GL_TEXTURE_BUFFER;
+    glGenTextures(1, &body_data_.handle);
+    glBindTexture(GL_TEXTURE_BUFFER, body_data_.handle);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, body_data_buffer_);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+    orbit_object.draw_mode = GL_LINE_STRIP;
+    // closed ring needs the first vertex twice
+    orbit_object.num_elements = GLsizei(max_orbit_segments + 1);
+    orbit_count = 0;
+}
 
-    //Attributes - index, size(3-dimensional), dtype, normalize data, byte-distance, offsets in bytes
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, GLsizei(sizeof(float) * 3), 0);
+void ApplicationSolar::addOrbit(std::shared_ptr<GeometryNode> const& planet)
+{
+    // propagated together, in the order of the planet list
+    std::size_t index = orbit_parents_.size();
+    orbital_elements const& orbit = planet->getOrbit();
+    kepler::add(orbit_batch_, orbit);
+
+    // two texels of orbital elements per ring, rings are generated in the vertex shader
+    // second texel holds the center, updated every frame
+    if (orbit.semi_major_axis > 0.0f) {
+        orbit_rings_.push_back(index);
+        orbit_texels_.push_back(glm::fvec4{orbit.semi_major_axis, orbit.eccentricity, orbit.inclination, orbit.ascending_node});
+        orbit_texels_.push_back(glm::fvec4{orbit.periapsis_argument, 0.0f, 0.0f, 0.0f});
+    }
+    orbit_centers_.resize(index + 1);
+    planet_placements_.resize(index + 1);
+    planet_models_.resize(index + 1);
+    planet_normals_.resize(index + 1);
+    draw_order_.push_back(index);
+    planet_textures_.resize(index + 1);
+    planet_depths_.resize(index + 1);
+
+    // matrices are filled while rendering, lights are not darkened on their night side
+    body_texels_.resize(9 * (index + 1));
+    float ambient = planet->getParent()->getIsLight() ? 1.0f : 0.3f;
+    body_texels_[9 * index + 8] = glm::fvec4{ambient, ambient, ambient, 0.0f};
+
+    // index of the body each holder orbits, -1 for holders attached to the root
+    auto parent = orbit_indices_.find(planet->getParent()->getParent().get());
+    orbit_parents_.push_back(parent == orbit_indices_.end() ? -1 : parent->second);
+    orbit_indices_.emplace(planet->getParent().get(), int(index));
+}
 
-    orbit_object.draw_mode = GL_LINE_LOOP;
-    orbit_object.num_elements = GLsizei(points_in_circle);
+void ApplicationSolar::uploadOrbitElements()
+{
+    // texture buffer grows with the streamed bodies, centers are updated every frame
+    glBindBuffer(GL_TEXTURE_BUFFER, orbit_object.vertex_BO);
+    glBufferData(GL_TEXTURE_BUFFER, GLsizeiptr(sizeof(glm::fvec4) * orbit_texels_.size()), orbit_texels_.data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    orbit_count = GLsizei(orbit_rings_.size());
+}
 
+void ApplicationSolar::uploadOrbitTessellation() {
+    shader_program const& orbits = m_shaders.at("orbits");
+    glUseProgram(orbits.handle);
+    glUniform1i(orbits.u_locs.at("OrbitElements"), 0);
+    glUniform1i(orbits.u_locs.at("MaxSegments"), GLint(max_orbit_segments));
+    glUniform1i(orbits.u_locs.at("MinSegments"), GLint(min_orbit_segments));
+    glUniform1f(orbits.u_locs.at("PixelsPerSegment"), 4.0f);
+    glUniform1f(orbits.u_locs.at("ViewportHeight"), float(img_height));
 }
 
 // =====================================================
 // Assignment 5
-void ApplicationSolar::initializeFrameBuffer(int width, int height) {
-    // create framebuffer object
-    glGenFramebuffers(1, &framebuffer.handle);
-    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer.handle);
-
-    // create texture object
-    // create texture attachment as color_attachment
-    texture_object texture;
-    glActiveTexture(GL_TEXTURE0);
-    glGenTextures(1, &texture.handle);
-    glBindTexture(GL_TEXTURE_2D, texture.handle);
-
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-    glBindTexture(GL_TEXTURE_2D, 0);
-
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture.handle, 0);
-
-    framebuffer.color_buffer = texture;
-    framebuffer.color_handle = texture.handle;
-
-    //create renderbuffer attachment (depth attachment)
-    unsigned int renderbuffer_object;
-    glGenRenderbuffers(1, &renderbuffer_object);
-    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer_object);
-
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT16, width, height);
-
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, renderbuffer_object);
-
-    framebuffer.depth_handle = renderbuffer_object;
-    glBindRenderbuffer(GL_RENDERBUFFER, 0);
-
-    GLenum drawBuffers[1] = { GL_COLOR_ATTACHMENT0 };
-    glDrawBuffers(1, drawBuffers);
-
-    /*// generate texture names
-    glGenTextures(1, &color_buffer.handle);
-    glBindTexture(color_buffer.target, color_buffer.handle);
-
-    // define texture sampling parameters
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    // define texture data and format
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
-
-    // set color attachment
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color_buffer.handle, 0);
-    framebuffer.color_buffer = color_buffer;
-
-    // create depth attachment as renderbuffer
-    glGenRenderbuffers(1, &framebuffer.depth_handle);
-    glBindRenderbuffer(GL_RENDERBUFFER, framebuffer.depth_handle);
-
-    // ERROR? - GL_DEBUG_SEVERITY_LOW - GL_DEBUG_TYPE_OTHER: Framebuffer detailed info: The driver allocated storage for renderbuffer 1.
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, GLsizei(width), GLsizei(height));
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, framebuffer.depth_handle);
-
-    // define which buffers to write
-    GLenum draw_buffers[1] = { GL_COLOR_ATTACHMENT0 };
-    glDrawBuffers(1, draw_buffers);*/
-
-    // check whether the framebuffer can be written
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
-        std::cout << "FRAMGEBUFFER DED!" << std::endl;
+void ApplicationSolar::initializeFrameBuffer(unsigned width, unsigned height) {
+    glm::uvec2 size{width, height};
+    // scene is rendered into a color texture with depth renderbuffer
+    if (scene_target == nullptr) {
+        scene_target = render_targets.acquire(size, scene_format, scene_depth_format);
     }
+    // storage is only replaced if the size actually changed
     else {
-        std::cout << "FRAMEBUFFER ON!" << std::endl;
-        //glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        render_targets.resize(scene_target, size, scene_format, scene_depth_format);
     }
-
+    // albedo with ambient intensity and signed view space normals
+    std::vector<GLenum> gbuffer_formats{GL_RGBA8, GL_RGB16F};
+    if (deferred_mode && gbuffer_target == nullptr) {
+        gbuffer_target = render_targets.acquire(size, gbuffer_formats, scene_depth_format);
+    }
+    else if (deferred_mode) {
+        render_targets.resize(gbuffer_target, size, gbuffer_formats, scene_depth_format);
+    }
+    else if (gbuffer_target != nullptr) {
+        render_targets.release(gbuffer_target);
+        render_targets.trim();
+        gbuffer_target = nullptr;
+    }
+    // the g-buffer is single sampled, lighting every sample would cost as much as the forward path
+    bool multisampled = msaa_samples > 1 && !deferred_mode;
+    if (multisampled && msaa_target == nullptr) {
+        msaa_target = render_targets.acquire(size, scene_format, scene_depth_format, msaa_samples);
+    }
+    else if (multisampled) {
+        render_targets.resize(msaa_target, size, scene_format, scene_depth_format, msaa_samples);
+    }
+    else if (msaa_target != nullptr) {
+        render_targets.release(msaa_target);
+        render_targets.trim();
+        msaa_target = nullptr;
+    }
+    // intermediates of the old size are not needed anymore
+    post_process.trimTargets();
 }
 
-void ApplicationSolar::initializeFullscreenQuad() {
-    // triangles
-    std::vector<GLfloat> quad = {
-        //v1
-        -1.0f, 1.0f, 0.0f, 1.0f,
-        //v2
-        -1.0f, -1.0f, 0.0f, 0.0f,
-        //v3
-        1.0f, -1.0f, 1.0f, 0.0f,
-        //v4
-        -1.0f, 1.0f, 0.0f, 1.0f,
-        //v5
-        1.0f, -1.0f, 1.0f, 0.0f,
-        //v6
-        1.0f, 1.0f, 1.0f, 1.0f
-    };
-
-    //create a new VertexArray
-    glGenVertexArrays(1, &fullscreen_quad.vertex_AO);
-    glBindVertexArray(fullscreen_quad.vertex_AO);
-
-    //generate a new Buffer and bind it to the new VertexArray
-    glGenBuffers(1, &fullscreen_quad.vertex_BO);
-    glBindBuffer(GL_ARRAY_BUFFER, fullscreen_quad.vertex_BO);
-
-    //specify the size of the data
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * quad.size(), quad.data(), GL_STATIC_DRAW);
-
-    // first attribute Array for positions
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, GLsizei(4 * sizeof(float)), nullptr);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, GLsizei(4 * sizeof(float)), (void*)(2 * sizeof(float)));
-
-    //specify the draw mode and the number of elements
-    fullscreen_quad.draw_mode = GL_TRIANGLES;
-    fullscreen_quad.num_elements = GLsizei(quad.size() / 4);
-
-    /*// generate vertex array object
-    glGenVertexArrays(1, &fullscreen_quad.vertex_AO);
-    // bind the array for attaching buffers
-    glBindVertexArray(fullscreen_quad.vertex_AO);
-
-    // generate generic buffer
-    glGenBuffers(1, &fullscreen_quad.vertex_BO);
-    // bind this as an vertex array buffer containing all attributes
-    glBindBuffer(GL_ARRAY_BUFFER, fullscreen_quad.vertex_BO);
-    // configure currently bound array buffer
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * triangles.size(), triangles.data(), GL_STATIC_DRAW);
-
-    // first attribute (position)
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, GLsizei(sizeof(float) * 5), 0);
-
-    // second attribute (color)
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, GLsizei(sizeof(float) * 5), (void*)(sizeof(float) * 3));
-
-    // store type of primitive to draw
-    fullscreen_quad.draw_mode = GL_TRIANGLE_STRIP;
-    // transfer number of indices to model object 
-    fullscreen_quad.num_elements = GLsizei(triangles.size() / 5);*/
+void ApplicationSolar::reportRenderTargets() const {
+    std::size_t count = render_targets.getTargetCount() + post_process.getPool().getTargetCount();
+    std::size_t bytes = render_targets.getMemoryUsage() + post_process.getPool().getMemoryUsage();
+    std::cout << "Render targets: " << count << " using " << float(bytes) / (1024.0f * 1024.0f) << " MiB" << std::endl;
 }
 // =====================================================
 
@@ -453,212 +571,473 @@ void ApplicationSolar::render() const {
     // =====================================================
     // Assignment 5
     // Bind it and render the scene to it and not to the Default one.
-    std::cout << "==============NOT DEFAULT==============" << std::endl;
-    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer.handle);    
+    // with multisampling the scene is drawn into the multisample target and resolved afterwards
+    render_target const* draw_target = msaa_target != nullptr ? msaa_target : scene_target;
+    glBindFramebuffer(GL_FRAMEBUFFER, draw_target->framebuffer.handle);
+    // targets keep the window size, a lower resolution only uses part of them so nothing is reallocated
+    resolution_.beginFrame();
+    render_size_ = resolution_.getRenderSize(glm::uvec2{img_width, img_height});
+    glViewport(0, 0, GLsizei(render_size_.x), GLsizei(render_size_.y));
     glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     glEnable(GL_DEPTH_TEST);
     // =====================================================
-    
-    // render Skybox
-    renderSkybox();
-    // render stars
-    renderStars();
+
+    // submit the frame prepared while the last one was submitted, the first one is prepared now
+    frame_pipeline_.wait();
+    if (frame_prepared_) {
+        submitted_slot_ = 1 - submitted_slot_;
+    }
+    else {
+        frames_[submitted_slot_].view_transform = m_view_transform;
+        frames_[submitted_slot_].time = glfwGetTime();
+        frames_[submitted_slot_].revision = state_revision_;
+        prepareFrame(submitted_slot_);
+        frame_prepared_ = true;
+    }
+    drawn_view_transform_ = frames_[submitted_slot_].view_transform;
+    drawn_revision_ = frames_[submitted_slot_].revision;
+    // the worker prepares the next frame meanwhile, so input shows one frame later
+    frame_packet& next = frames_[1 - submitted_slot_];
+    next.view_transform = m_view_transform;
+    next.time = glfwGetTime();
+    next.revision = state_revision_;
+    frame_pipeline_.kick(1 - submitted_slot_);
+
+    // binds between frames, e.g. by the post processing chain, bypass the cache
+    state_.invalidate();
+    state_.resetCounters();
+
+    // matrices of the moved bodies
+    uploadFrame(frames_[submitted_slot_]);
     // render lightnodes
     renderLightNodes();
-    // render planets
-    auto planets = solarSystem_.getPlanets();
-    for (auto planet : planets){
-        renderPlanet(planet);
+    if (deferred_mode) {
+        // planets are only rasterized here, shading happens once per covered pixel
+        glBindFramebuffer(GL_FRAMEBUFFER, gbuffer_target->framebuffer.handle);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    }
+    if (depth_prepass) {
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        renderDepthPrepass();
+        render_queue_.execute(state_);
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        // only the nearest fragment of each pixel passes
+        glDepthFunc(GL_LEQUAL);
+        glDepthMask(GL_FALSE);
+    }
+    glBeginQuery(GL_SAMPLES_PASSED, overdraw_queries_[overdraw_frame_ % 2]);
+    renderPlanets();
+    render_queue_.execute(state_);
+    glEndQuery(GL_SAMPLES_PASSED);
+    if (depth_prepass) {
+        glDepthFunc(GL_LESS);
+        glDepthMask(GL_TRUE);
+    }
+    if (deferred_mode) {
+        // stars and orbits are hidden behind planets as in the forward path
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, gbuffer_target->framebuffer.handle);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, scene_target->framebuffer.handle);
+        glBlitFramebuffer(0, 0, GLint(render_size_.x), GLint(render_size_.y), 0, 0, GLint(render_size_.x),
+                          GLint(render_size_.y), GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+        glBindFramebuffer(GL_FRAMEBUFFER, scene_target->framebuffer.handle);
+        renderLighting();
     }
-    // render Orbits
+    // record stars, Orbits and Skybox, then draw them sorted by state
+    renderStars();
     renderOrbits();
+    renderSkybox();
+    render_queue_.execute(state_);
+    reportStateChanges();
+    reportOverdraw();
+
+    if (msaa_target != nullptr) {
+        // average the samples of each pixel, post processing reads a regular texture
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, msaa_target->framebuffer.handle);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, scene_target->framebuffer.handle);
+        glBlitFramebuffer(0, 0, GLint(render_size_.x), GLint(render_size_.y), 0, 0, GLint(render_size_.x),
+                          GLint(render_size_.y), GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    }
 
     // =====================================================
     // Assignment 5
-    // Render changed to default to display screen
-    std::cout << "==============SWITCH TO DEFAULT TO RENDER TO SCREEN==============" << std::endl;
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT);
-    glDisable(GL_DEPTH_TEST);
-    renderFullscreenquad();
+    // post processing chain, last pass writes to the default framebuffer
+    // the first pass scales the rendered part up to the window
+    glm::fvec2 input_scale = glm::fvec2{render_size_} / glm::fvec2{float(img_width), float(img_height)};
+    post_process.render(m_shaders, scene_target->framebuffer.color_handle, 0, glm::uvec2{img_width, img_height}, input_scale);
+    resolution_.endFrame();
+    reportResolution();
     // =====================================================
 }
 
-// =====================================================
-// Assignment 5
-void ApplicationSolar::renderFullscreenquad()const {
-    // full-screen quad
-    glUseProgram(m_shaders.at("screen_quad").handle);
-
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, framebuffer.color_handle);
-
-    // add sampler
-    int samplerLocation = glGetUniformLocation(m_shaders.at("screen_quad").handle, "screen_Texture");
-    glUniform1i(samplerLocation, 0);//framebuffer_obj.texture_obj.handle);
-
-    //render quad
-    glBindVertexArray(fullscreen_quad.vertex_AO);
-    glDrawArrays(fullscreen_quad.draw_mode, 0, fullscreen_quad.num_elements);
-
-    /*
-    //std::cout << "================1111111================" << std::endl;
-    //// extract texture from framebuffer
-    //glActiveTexture(GL_TEXTURE0 + 12);
-    //std::cout << "================2222222================" << std::endl;
-    //glBindTexture(framebuffer.color_buffer.target, framebuffer.color_buffer.handle);
-
-    //std::cout << "================3333333================" << std::endl;
-    //// upload texture to shader
-    //auto temp_texture = glGetUniformLocation(m_shaders.at("screen_quad").handle, "fullScreenQuad_texture");
-    //std::cout << "================4444444================" << std::endl;
-    //glUniform1i(temp_texture, framebuffer.color_buffer.handle);
-
-    //std::cout << "================5555555================" << std::endl;
-    //// render quad
-    //glBindVertexArray(fullscreen_quad.vertex_AO);
-    //std::cout << "================6666666================" << std::endl;
-    //glDrawArrays(fullscreen_quad.draw_mode, 0, fullscreen_quad.num_elements);
-    //std::cout << "================7777777================" << std::endl;
-    */
-}
-// =====================================================
-
 void ApplicationSolar::renderLightNodes() const {
+    frame_packet const& frame = frames_[submitted_slot_];
+    if (deferred_mode) {
+        // all lights are accumulated by the lighting pass
+        GLsizei count = GLsizei(std::min(frame.light_positions.size(), max_deferred_lights));
+        shader_program const& lighting = m_shaders.at("deferred_lighting");
+        state_.useProgram(lighting.handle);
+        glUniform1i(lighting.u_locs.at("LightCount"), count);
+        if (count > 0) {
+            glUniform3fv(lighting.u_locs.at("LightPositions"), count, glm::value_ptr(frame.light_positions[0]));
+            glUniform3fv(lighting.u_locs.at("LightColors"), count, glm::value_ptr(frame.light_colors[0]));
+            glUniform1fv(lighting.u_locs.at("LightIntensities"), count, frame.light_intensities.data());
+        }
+        glUniform2f(lighting.u_locs.at("TextureScale"), float(render_size_.x) / float(img_width),
+                    float(render_size_.y) / float(img_height));
+        return;
+    }
 
     // bind shader to upload uniforms
-    glUseProgram(m_shaders.at("planet").handle);
+    state_.useProgram(m_shaders.at("planet").handle);
 
     // upload light uniforms
-    auto lightNodes = solarSystem_.getLightNodes();
-    for(auto lightNode : lightNodes){
+    for (std::size_t light = 0; light < frame.light_positions.size(); ++light) {
         // upload light intensity
         auto temp_intensity = glGetUniformLocation(m_shaders.at("planet").handle, "light_intensity");
-        glUniform1f(temp_intensity, lightNode->getIntensity());
+        glUniform1f(temp_intensity, frame.light_intensities[light]);
 
         // upload light color
         auto temp_color = glGetUniformLocation(m_shaders.at("planet").handle, "light_color");
-        glUniform3f(temp_color, lightNode->getColor()[0], lightNode->getColor()[1], lightNode->getColor()[2]);
-
-        // calculate position
-        glm::fvec4 light_position = lightNode->getWorldTransform() * glm::fvec4{0, 0, 0, 1};
+        glUniform3fv(temp_color, 1, glm::value_ptr(frame.light_colors[light]));
 
         // upload position
         auto temp_position = glGetUniformLocation(m_shaders.at("planet").handle, "light_position");
-        glUniform3f(temp_position, light_position[0] / light_position[3], light_position[1] / light_position[3], light_position[2] / light_position[3]);
+        glUniform3fv(temp_position, 1, glm::value_ptr(frame.light_positions[light]));
     }
 }
 
-void ApplicationSolar::renderStars()const{
-    // bind shader to upload uniforms
-    glUseProgram(m_shaders.at("star").handle);
-
-    glm::fmat4 matrix = glm::fmat4();
-    glUniformMatrix4fv(m_shaders.at("star").u_locs.at("ModelMatrix"), 1, GL_FALSE, glm::value_ptr(matrix));
-
-    // bind the VAO to draw
-    glBindVertexArray(star_object.vertex_AO);
-
-    // draw stars
-    glDrawArrays(star_object.draw_mode, GLint(0), star_object.num_elements);
+void ApplicationSolar::gatherLights(frame_packet& frame) const {
+    frame.light_positions.clear();
+    frame.light_colors.clear();
+    frame.light_intensities.clear();
+    for (auto const& lightNode : solarSystem_.getLightNodes()) {
+        // calculate position
+        glm::fvec4 light_position = lightNode->getWorldTransform() * glm::fvec4{0, 0, 0, 1};
+        frame.light_positions.push_back(glm::fvec3{light_position} / light_position.w);
+        frame.light_colors.push_back(lightNode->getColor());
+        frame.light_intensities.push_back(lightNode->getIntensity());
+    }
 }
 
-void ApplicationSolar::renderPlanet(std::shared_ptr<GeometryNode> planet)const{
-    glUseProgram(m_shaders.at("planet").handle);
+void ApplicationSolar::renderStars()const{
+    render_queue_.submit(opaque_layer, m_shaders.at("star").handle, star_object.vertex_AO, GL_NONE, 0, 0.0f, star_pass_);
+}
 
-    glm::fmat4 planetWorldTransform = planet->getParent()->getWorldTransform();
-    glUniformMatrix4fv(m_shaders.at("planet").u_locs.at("ModelMatrix"), 1, GL_FALSE, glm::value_ptr(planetWorldTransform));
+void ApplicationSolar::prepareFrame(std::size_t slot) const {
+    frame_packet& frame = frames_[slot];
+    // move bodies along their orbits
+    updateOrbits(frame);
+    // lights are children of the moved holders
+    gatherLights(frame);
+    preparePlanets(frame);
+}
 
-    // extra matrix for normal transformation to keep them orthogonal to surface
-    glm::fmat4 planet_normal_matrix = glm::inverseTranspose(glm::inverse(m_view_transform) * planetWorldTransform);
-    glUniformMatrix4fv(m_shaders.at("planet").u_locs.at("NormalMatrix"), 1, GL_FALSE, glm::value_ptr(planet_normal_matrix));
+void ApplicationSolar::uploadFrame(frame_packet const& frame) const {
+    if (frame.view_transform != uploaded_view_transform_) {
+        uploadCamera(frame.view_transform, false);
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, body_data_buffer_);
+    glBufferData(GL_TEXTURE_BUFFER, GLsizeiptr(sizeof(glm::fvec4) * frame.body_texels.size()), frame.body_texels.data(), GL_STREAM_DRAW);
+    // rings added since the frame was prepared keep the centers of their upload
+    if (!frame.orbit_texels.empty()) {
+        glBindBuffer(GL_TEXTURE_BUFFER, orbit_object.vertex_BO);
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, GLsizeiptr(sizeof(glm::fvec4) * frame.orbit_texels.size()), frame.orbit_texels.data());
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    state_.bindTexture(1, GL_TEXTURE_BUFFER, body_data_.handle);
+    meshes_.setCommands(frame.draw_commands);
+}
 
-    // set color
-    auto temp_color = glGetUniformLocation(m_shaders.at("planet").handle, "planet_color");
-    glm::fvec3 color = planet->getColor();
-    glUniform3f(temp_color, color[0], color[1], color[2]);
+void ApplicationSolar::preparePlanets(frame_packet& frame) const {
+    auto const& planets = solarSystem_.getPlanets();
+    frame.planet_groups.clear();
+    frame.draw_commands.clear();
+    // ambient set in addOrbit
+    frame.body_texels = body_texels_;
+    if (planets.empty()) {
+        return;
+    }
+    // textures arrive while streaming, so the grouping is redone every frame
+    std::size_t index = 0;
+    for (auto const& planet : planets) {
+        planet_textures_[index++] = planet->getTextureObject().handle;
+    }
+    // model and normal matrices batched in updateOrbits
+    glm::fmat4 view_matrix = glm::inverse(frame.view_transform);
+    JobSystem::shared().parallelFor("pack planets", index, planets_per_job, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t planet = begin; planet < end; ++planet) {
+            for (int column = 0; column < 4; ++column) {
+                frame.body_texels[9 * planet + std::size_t(column)] = planet_models_[planet][column];
+                frame.body_texels[9 * planet + 4 + std::size_t(column)] = planet_normals_[planet][column];
+            }
+            planet_depths_[planet] = -(view_matrix * planet_models_[planet][3]).z;
+        }
+    });
+
+    // bodies sharing a texture are drawn together, the base instance selects their matrices
+    // within a texture nearer bodies come first, so they occlude the others before these are shaded
+    std::sort(draw_order_.begin(), draw_order_.end(), [this](std::size_t a, std::size_t b) {
+        if (planet_textures_[a] != planet_textures_[b]) {
+            return planet_textures_[a] < planet_textures_[b];
+        }
+        return planet_depths_[a] < planet_depths_[b];
+    });
+    for (std::size_t planet : draw_order_) {
+        frame.draw_commands.push_back(meshes_.makeCommand(sphere_mesh_, GLuint(planet)));
+    }
 
-    // set ambient intensity
-    auto temp_ambient =  glGetUniformLocation(m_shaders.at("planet").handle, "ambient_intensity");
+    std::size_t first = 0;
+    while (first < draw_order_.size()) {
+        GLuint texture = planet_textures_[draw_order_[first]];
+        std::size_t last = first + 1;
+        while (last < draw_order_.size() && planet_textures_[draw_order_[last]] == texture) {
+            ++last;
+        }
+        frame.planet_groups.push_back(draw_group{first, last - first, texture, planet_depths_[draw_order_[first]]});
+        first = last;
+    }
+}
 
-    if (planet->getParent()->getIsLight() == true) {
-        glUniform3f(temp_ambient, 1.0f, 1.0f, 1.0f);
-    } else {
-        glUniform3f(temp_ambient, 0.3f, 0.3f, 0.3f);
+void ApplicationSolar::renderPlanets() const {
+    // one queued draw per texture, bound to the first unit, groups ordered by their nearest body
+    GLuint program = m_shaders.at(getPlanetProgram()).handle;
+    std::vector<draw_group> const& groups = frames_[submitted_slot_].planet_groups;
+    for (std::size_t group = 0; group < groups.size(); ++group) {
+        draw_group const& planets = groups[group];
+        render_queue_.submit(planet_layer, program, meshes_.getVertexArray(), GL_TEXTURE_2D, planets.texture,
+                             planets.depth, planet_pass_, group);
     }
+}
 
-    // access texture
-    glActiveTexture(GL_TEXTURE0 + planet->getIndex());
-    texture_object textureObject = planet->getTextureObject();
-    glBindTexture(textureObject.target, textureObject.handle);
+void ApplicationSolar::renderDepthPrepass() const {
+    // textures do not matter for depth, so every group shares the state
+    GLuint program = m_shaders.at("planet_depth").handle;
+    std::vector<draw_group> const& groups = frames_[submitted_slot_].planet_groups;
+    for (std::size_t group = 0; group < groups.size(); ++group) {
+        render_queue_.submit(planet_layer, program, meshes_.getVertexArray(), GL_NONE, 0,
+                             groups[group].depth, depth_pass_, group);
+    }
+}
 
-    // upload texture to shader
-    auto temp_texture = glGetUniformLocation(m_shaders.at("planet").handle, "planet_texture");
-    glUseProgram(m_shaders.at("planet").handle);
-    glUniform1i(temp_texture, textureObject.handle);
+void ApplicationSolar::updateOrbits(frame_packet& frame) const {
+    double now = frame.time;
+    float time = float(now) * moving_time;
+    if (nbody_mode) {
+        // long frames are cut, otherwise close encounters explode
+        float dt = moving_time ? float(std::min(now - last_update_time_, 0.05)) : 0.0f;
+        unsigned substeps = unsigned(std::ceil(dt / max_nbody_step));
+        for (unsigned i = 0; i < substeps; ++i) {
+            nbody_.step(dt / float(substeps));
+        }
+    }
+    else {
+        // all bodies at once, positions relative to the body they orbit
+        kepler::propagate(orbit_batch_, time);
+    }
+    last_update_time_ = now;
+
+    auto const& planets = solarSystem_.getPlanets();
+    std::size_t index = 0;
+    for (auto const& planet : planets) {
+        // parents come first in the planet list, so their placement is already updated
+        int parent = orbit_parents_[index];
+        glm::fvec3 center = parent < 0 ? glm::fvec3{0.0f} : glm::fvec3{planet_placements_[std::size_t(parent)][3]};
+        orbit_centers_[index] = center;
+        glm::fvec3 position = nbody_mode ? nbody_.getPosition(index)
+                                         : center + glm::fvec3{orbit_batch_.x[index], orbit_batch_.y[index], orbit_batch_.z[index]};
+
+        glm::fmat4 placement = glm::translate(glm::fmat4{}, position);
+        planet_placements_[index] = glm::rotate(placement, time * planet->getSpeed(), glm::fvec3{0.0f, 1.0f, 0.0f});
+        planet_models_[index] = planet->getParent()->getLocalTransform();
+        ++index;
+    }
 
-    //    auto cell_sharing = glGetUniformLocation(m_shaders.at("planet").handle, "CellShadingMode");
-    //    glUniform1f(cell_sharing , cellShading_Mode);
+    // world and normal matrices of all holders in one pass each, split into jobs for large scenes
+    glm::fmat4 view_matrix = glm::inverse(frame.view_transform);
+    JobSystem::shared().parallelFor("planet matrices", index, planets_per_job, [&](std::size_t begin, std::size_t end) {
+        transform_batch::multiply(&planet_placements_[begin], &planet_models_[begin], &planet_models_[begin], end - begin);
+        transform_batch::normal_matrices(view_matrix, &planet_models_[begin], &planet_normals_[begin], end - begin);
+    });
+    index = 0;
+    for (auto const& planet : planets) {
+        planet->getParent()->assignWorldTransform(planet_models_[index++]);
+    }
 
-    // bind the VAO to draw
-    glBindVertexArray(planet_object.vertex_AO);
-    glDrawElements(planet_object.draw_mode, planet_object.num_elements, model::INDEX.type, NULL);
+    frame.orbit_texels.clear();
+    if (nbody_mode) {
+        return;
+    }
+    // rings are centered on the parent body
+    for (std::size_t i = 0; i < orbit_rings_.size(); ++i) {
+        glm::fvec3 const& center = orbit_centers_[orbit_rings_[i]];
+        orbit_texels_[2 * i + 1] = glm::fvec4{orbit_texels_[2 * i + 1].x, center};
+    }
+    frame.orbit_texels = orbit_texels_;
+}
 
-    // calculate next step
-    planetWorldTransform = glm::rotate(planet->getParent()->getParent()->getWorldTransform(), float(glfwGetTime()) * moving_time * planet->getSpeed(), glm::fvec3{0.0f, 1.0f, 0.0f});
-    planet->getParent()->setWorldTransform(planetWorldTransform);
+void ApplicationSolar::startNBody() {
+    nbody_.clear();
+    double time = glfwGetTime() * moving_time;
+    // bodies start where the orbits put them, holders are indexed to find the body orbited
+    std::map<Node*, std::size_t> bodies{};
+    for (auto const& planet : solarSystem_.getPlanets()) {
+        std::shared_ptr<Node> holder = planet->getParent();
+        glm::fvec3 position{holder->getWorldTransform()[3]};
+        // density of the sun for all bodies, so masses match the sizes on screen
+        float mass = std::pow(planet->getSize() / 0.5f, 3.0f);
+
+        glm::fvec3 velocity{0.0f};
+        auto parent = bodies.find(holder->getParent().get());
+        orbital_elements const& orbit = planet->getOrbit();
+        if (parent != bodies.end() && orbit.semi_major_axis > 0.0f) {
+            // direction of travel on the ellipse, speed from vis-viva for the mass of the parent
+            glm::fvec3 now = kepler::position(orbit, float(time));
+            glm::fvec3 later = kepler::position(orbit, float(time) + 0.001f);
+            float radius = glm::length(now);
+            float speed = std::sqrt(nbody_.getMass(parent->second) * (2.0f / radius - 1.0f / orbit.semi_major_axis));
+            velocity = nbody_.getVelocity(parent->second) + glm::normalize(later - now) * speed;
+        }
+        std::size_t body = nbody_.addBody(position, velocity, mass);
+        bodies[holder.get()] = body;
+        // first body without parent body is the center for the children of its parent node
+        if (parent == bodies.end()) {
+            bodies.emplace(holder->getParent().get(), body);
+        }
+    }
+    last_update_time_ = glfwGetTime();
 }
 
 void ApplicationSolar::renderOrbits() const
 {
-    //go through planets and get distance and set as radius -> scale of circle. not yet correct
-    for (auto const& planet : solarSystem_.getPlanets()) {
-        glm::fmat4 orbit_matrix = glm::fmat4(1.0f);
-        float radius = planet->getDistanceToOrigin().x;
-        orbit_matrix = glm::scale(orbit_matrix, glm::fvec3{radius, radius, radius});
-
-        glUseProgram(m_shaders.at("orbits").handle);
-        glUniformMatrix4fv(m_shaders.at("orbits").u_locs.at("OrbitMatrix"), 1, GL_FALSE, glm::value_ptr(orbit_matrix));
-        glBindVertexArray(orbit_object.vertex_AO);
-        glDrawArrays(orbit_object.draw_mode, GLint(0), orbit_object.num_elements);
+    // rings show the keplerian elements, which do not apply to the simulation
+    if (nbody_mode) {
+        return;
     }
+    // all rings in one draw, one instance per orbit
+    render_queue_.submit(opaque_layer, m_shaders.at("orbits").handle, orbit_object.vertex_AO,
+                         GL_TEXTURE_BUFFER, orbit_elements.handle, 0.0f, orbit_pass_);
+}
+
+void ApplicationSolar::renderLighting() const {
+    render_queue_.submit(lighting_layer, m_shaders.at("deferred_lighting").handle, lighting_object.vertex_AO,
+                         GL_TEXTURE_2D, gbuffer_target->framebuffer.color_handles[0], 0.0f, lighting_pass_);
+}
+
+std::string const& ApplicationSolar::getPlanetProgram() const {
+    static std::string const forward{"planet"};
+    static std::string const deferred{"planet_gbuffer"};
+    return deferred_mode ? deferred : forward;
 }
 
 void ApplicationSolar::renderSkybox() const {
-    glDepthMask(GL_FALSE);
-    glUseProgram(m_shaders.at("skybox").handle);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, skybox_texture_obj_.handle);
-    glBindVertexArray(skybox_object.vertex_AO);
-    glDrawElements(skybox_object.draw_mode, skybox_object.num_elements, model::INDEX.type, NULL);
-    glDepthMask(GL_TRUE);
+    render_queue_.submit(background_layer, m_shaders.at("skybox").handle, meshes_.getVertexArray(),
+                         GL_TEXTURE_CUBE_MAP, skybox_texture_obj_.handle, 0.0f, skybox_pass_);
 }
 
-void ApplicationSolar::uploadView(std::string shader_name) {
-    // =====================================================
-    // Assignment 5
-    if (shader_name == "screen_quad") {
-        glUseProgram(m_shaders.at("screen_quad").handle);
+void ApplicationSolar::initializeRenderQueue() {
+    render_queue_.setDepthSorted(planet_layer, true);
+    glGenQueries(2, overdraw_queries_);
+
+    // program, vertex array and texture are bound by the queue before each of these runs
+    // the skybox lies on the far plane and only covers pixels nothing else was drawn to
+    skybox_pass_ = render_queue_.addPass([this](std::size_t) {
+        glDepthFunc(GL_LEQUAL);
+        glDepthMask(GL_FALSE);
+        meshes_.draw(skybox_mesh_);
+        glDepthMask(GL_TRUE);
+        glDepthFunc(GL_LESS);
+    });
+    star_pass_ = render_queue_.addPass([this](std::size_t) {
+        glm::fmat4 matrix = glm::fmat4();
+        glUniformMatrix4fv(m_shaders.at("star").u_locs.at("ModelMatrix"), 1, GL_FALSE, glm::value_ptr(matrix));
+        glDrawArrays(star_object.draw_mode, GLint(0), star_object.num_elements);
+    });
+    planet_pass_ = render_queue_.addPass([this](std::size_t group) {
+        draw_group const& planets = frames_[submitted_slot_].planet_groups[group];
+        meshes_.drawCommands(planets.first, planets.count, m_shaders.at(getPlanetProgram()).u_locs.at("DrawOffset"));
+    });
+    depth_pass_ = render_queue_.addPass([this](std::size_t group) {
+        draw_group const& planets = frames_[submitted_slot_].planet_groups[group];
+        meshes_.drawCommands(planets.first, planets.count, m_shaders.at("planet_depth").u_locs.at("DrawOffset"));
+    });
+    lighting_pass_ = render_queue_.addPass([this](std::size_t) {
+        shader_program const& lighting = m_shaders.at("deferred_lighting");
+        state_.bindTexture(1, GL_TEXTURE_2D, gbuffer_target->framebuffer.color_handles[1]);
+        state_.bindTexture(2, GL_TEXTURE_2D, gbuffer_target->framebuffer.depth_handle);
+        glUniform1i(lighting.u_locs.at("AlbedoTexture"), 0);
+        glUniform1i(lighting.u_locs.at("NormalTexture"), 1);
+        glUniform1i(lighting.u_locs.at("DepthTexture"), 2);
+        glm::fmat4 view_matrix = glm::inverse(frames_[submitted_slot_].view_transform);
+        glm::fmat4 inverse_projection = glm::inverse(m_view_projection);
+        glUniformMatrix4fv(lighting.u_locs.at("ViewMatrix"), 1, GL_FALSE, glm::value_ptr(view_matrix));
+        glUniformMatrix4fv(lighting.u_locs.at("InverseProjectionMatrix"), 1, GL_FALSE, glm::value_ptr(inverse_projection));
+        // covers the whole screen, depth of the planets is kept for the following draws
+        glDisable(GL_DEPTH_TEST);
+        glDepthMask(GL_FALSE);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glDepthMask(GL_TRUE);
+        glEnable(GL_DEPTH_TEST);
+    });
+    orbit_pass_ = render_queue_.addPass([this](std::size_t) {
+        glDrawArraysInstanced(orbit_object.draw_mode, GLint(0), orbit_object.num_elements, orbit_count);
+    });
+}
 
-        glUniform1i(m_shaders.at("screen_quad").u_locs.at("horizontal_Mirroring"), horizontal_mirroring);
-        glUniform1i(m_shaders.at("screen_quad").u_locs.at("vertical_Mirroring"), vertical_mirroring);
-        glUniform1i(m_shaders.at("screen_quad").u_locs.at("greyscale_mode"), greyscale_mode);
-        glUniform1i(m_shaders.at("screen_quad").u_locs.at("blur_mode"), blur_mode);
-        glUniform2f(m_shaders.at("screen_quad").u_locs.at("texture_Size"), img_width, img_height);
+void ApplicationSolar::reportStateChanges() const {
+    std::size_t issued = state_.getIssuedCount();
+    std::size_t skipped = state_.getSkippedCount();
+    if (issued == issued_state_changes_ && skipped == skipped_state_changes_) {
+        return;
     }
-    // =====================================================
-    else {
-        // vertices are transformed in camera space, so camera transform must be inverted
-        glm::fmat4 view_matrix = glm::inverse(m_view_transform);
-        // upload matrix to gpu
-        glUniformMatrix4fv(m_shaders.at(shader_name).u_locs.at("ViewMatrix"),
-            1, GL_FALSE, glm::value_ptr(view_matrix));
+    issued_state_changes_ = issued;
+    skipped_state_changes_ = skipped;
+    std::cout << "State changes per frame: " << issued << " issued, " << skipped << " eliminated" << std::endl;
+}
+
+void ApplicationSolar::reportOverdraw() const {
+    // result of the previous frame, waiting for the current one would stall
+    GLuint previous = overdraw_queries_[(overdraw_frame_ + 1) % 2];
+    if (overdraw_frame_ > 0) {
+        GLuint available = 0;
+        glGetQueryObjectuiv(previous, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available != 0) {
+            glGetQueryObjectuiv(previous, GL_QUERY_RESULT, &shaded_fragments_);
+        }
+    }
+    ++overdraw_frame_;
+
+    double now = glfwGetTime();
+    if (!overdraw_report || now - last_overdraw_report_ < 1.0) {
+        return;
     }
+    last_overdraw_report_ = now;
+    // the query counts samples, not pixels
+    float pixels = float(render_size_.x) * float(render_size_.y) * float(msaa_target != nullptr ? msaa_target->samples : 1);
+    std::cout << "Planet fragments shaded: " << shaded_fragments_ << ", " << float(shaded_fragments_) / pixels
+              << " per pixel" << (depth_prepass ? " with" : " without") << " depth pre-pass" << std::endl;
 }
 
-void ApplicationSolar::uploadProjection(std::string shader_name) {
+void ApplicationSolar::reportResolution() const {
+    double now = glfwGetTime();
+    if (!resolution_.getEnabled() || now - last_resolution_report_ < 1.0) {
+        return;
+    }
+    last_resolution_report_ = now;
+    std::cout << "Render scale " << resolution_.getScale() << " (" << render_size_.x << "x" << render_size_.y << "), "
+              << resolution_.getFrameTime() << " ms " << (resolution_.getTimerSupport() ? "gpu" : "frame") << " time of "
+              << resolution_.getBudget() << " ms budget" << std::endl;
+}
+
+void ApplicationSolar::uploadView(std::string const& shader_name) {
+    // vertices are transformed in camera space, so camera transform must be inverted
+    glm::fmat4 view_matrix = glm::inverse(m_view_transform);
+    // upload matrix to gpu
+    glUniformMatrix4fv(m_shaders.at(shader_name).u_locs.at("ViewMatrix"),
+        1, GL_FALSE, glm::value_ptr(view_matrix));
+}
+
+void ApplicationSolar::uploadProjection(std::string const& shader_name) {
     // upload matrix to gpu
     glUniformMatrix4fv(m_shaders.at(shader_name).u_locs.at("ProjectionMatrix"),
                        1, GL_FALSE, glm::value_ptr(m_view_projection));
@@ -671,6 +1050,20 @@ void ApplicationSolar::uploadUniforms() {
     // upload uniform values to new locations
     uploadView("planet");
     uploadProjection("planet");
+    // texture of the planet and its draw data
+    glUniform1i(m_shaders.at("planet").u_locs.at("planet_texture"), 0);
+    glUniform1i(m_shaders.at("planet").u_locs.at("BodyData"), 1);
+
+    glUseProgram(m_shaders.at("planet_gbuffer").handle);
+    uploadView("planet_gbuffer");
+    uploadProjection("planet_gbuffer");
+    glUniform1i(m_shaders.at("planet_gbuffer").u_locs.at("planet_texture"), 0);
+    glUniform1i(m_shaders.at("planet_gbuffer").u_locs.at("BodyData"), 1);
+
+    glUseProgram(m_shaders.at("planet_depth").handle);
+    uploadView("planet_depth");
+    uploadProjection("planet_depth");
+    glUniform1i(m_shaders.at("planet_depth").u_locs.at("BodyData"), 1);
 
     // bind shader to which to upload unforms
     glUseProgram(m_shaders.at("star").handle);
@@ -683,6 +1076,7 @@ void ApplicationSolar::uploadUniforms() {
     // upload uniform values to new locations
     uploadView("orbits");
     uploadProjection("orbits");
+    uploadOrbitTessellation();
 
     // bind shader to which to upload unforms
     glUseProgram(m_shaders.at("skybox").handle);
@@ -692,11 +1086,10 @@ void ApplicationSolar::uploadUniforms() {
 
     // =====================================================
     // Assignment 5
-    // bind shader to which to upload unforms
-    glUseProgram(m_shaders.at("screen_quad").handle);
-    // upload uniform values to new locations
-    uploadView("screen_quad");
+    // upload effect parameters of the post processing chain
+    post_process.uploadUniforms(m_shaders, glm::uvec2{img_width, img_height});
     // =====================================================
+    uploaded_view_transform_ = m_view_transform;
 }
 
 ///////////////////////////// intialisation functions /////////////////////////
@@ -706,11 +1099,45 @@ void ApplicationSolar::initializeShaderPrograms() {
     m_shaders.emplace("planet", shader_program{{{GL_VERTEX_SHADER, m_resource_path + "shaders/simple.vert"},
                                                 {GL_FRAGMENT_SHADER, m_resource_path + "shaders/simple.frag"}}});
     // request uniform locations for shader program
-    m_shaders.at("planet").u_locs["NormalMatrix"] = -1;
-    m_shaders.at("planet").u_locs["ModelMatrix"] = -1;
+    m_shaders.at("planet").u_locs["BodyData"] = -1;
+    m_shaders.at("planet").u_locs["DrawOffset"] = -1;
+    m_shaders.at("planet").u_locs["planet_texture"] = -1;
     m_shaders.at("planet").u_locs["ViewMatrix"] = -1;
     m_shaders.at("planet").u_locs["ProjectionMatrix"] = -1;
 
+    // same shaders writing material and normal for deferred shading
+    m_shaders.emplace("planet_gbuffer", shader_program{{{GL_VERTEX_SHADER, m_resource_path + "shaders/simple.vert"},
+                                                        {GL_FRAGMENT_SHADER, m_resource_path + "shaders/simple.frag"}},
+                                                       {"GBUFFER"}});
+    m_shaders.at("planet_gbuffer").u_locs["BodyData"] = -1;
+    m_shaders.at("planet_gbuffer").u_locs["DrawOffset"] = -1;
+    m_shaders.at("planet_gbuffer").u_locs["planet_texture"] = -1;
+    m_shaders.at("planet_gbuffer").u_locs["ViewMatrix"] = -1;
+    m_shaders.at("planet_gbuffer").u_locs["ProjectionMatrix"] = -1;
+
+    // only depth, for the pre-pass
+    m_shaders.emplace("planet_depth", shader_program{{{GL_VERTEX_SHADER, m_resource_path + "shaders/simple.vert"},
+                                                      {GL_FRAGMENT_SHADER, m_resource_path + "shaders/depth_only.frag"}}});
+    m_shaders.at("planet_depth").u_locs["BodyData"] = -1;
+    m_shaders.at("planet_depth").u_locs["DrawOffset"] = -1;
+    m_shaders.at("planet_depth").u_locs["ViewMatrix"] = -1;
+    m_shaders.at("planet_depth").u_locs["ProjectionMatrix"] = -1;
+
+    // lights the g-buffer
+    m_shaders.emplace("deferred_lighting", shader_program{{{GL_VERTEX_SHADER, m_resource_path + "shaders/deferred_lighting.vert"},
+                                                           {GL_FRAGMENT_SHADER, m_resource_path + "shaders/deferred_lighting.frag"}},
+                                                          {"MAX_LIGHTS " + std::to_string(max_deferred_lights)}});
+    m_shaders.at("deferred_lighting").u_locs["AlbedoTexture"] = -1;
+    m_shaders.at("deferred_lighting").u_locs["NormalTexture"] = -1;
+    m_shaders.at("deferred_lighting").u_locs["DepthTexture"] = -1;
+    m_shaders.at("deferred_lighting").u_locs["InverseProjectionMatrix"] = -1;
+    m_shaders.at("deferred_lighting").u_locs["TextureScale"] = -1;
+    m_shaders.at("deferred_lighting").u_locs["ViewMatrix"] = -1;
+    m_shaders.at("deferred_lighting").u_locs["LightCount"] = -1;
+    m_shaders.at("deferred_lighting").u_locs["LightPositions"] = -1;
+    m_shaders.at("deferred_lighting").u_locs["LightColors"] = -1;
+    m_shaders.at("deferred_lighting").u_locs["LightIntensities"] = -1;
+
     // store shader program objects in container
     m_shaders.emplace("star", shader_program{{{GL_VERTEX_SHADER,m_resource_path + "shaders/vao.vert"},
                                               {GL_FRAGMENT_SHADER, m_resource_path + "shaders/vao.frag"}}});
@@ -723,7 +1150,11 @@ void ApplicationSolar::initializeShaderPrograms() {
                       shader_program{
                                      {{GL_VERTEX_SHADER, m_resource_path + "shaders/orbits.vert"},
                                       {GL_FRAGMENT_SHADER, m_resource_path + "shaders/orbits.frag"}}});
-    m_shaders.at("orbits").u_locs["OrbitMatrix"] = -1;
+    m_shaders.at("orbits").u_locs["OrbitElements"] = -1;
+    m_shaders.at("orbits").u_locs["MaxSegments"] = -1;
+    m_shaders.at("orbits").u_locs["MinSegments"] = -1;
+    m_shaders.at("orbits").u_locs["PixelsPerSegment"] = -1;
+    m_shaders.at("orbits").u_locs["ViewportHeight"] = -1;
     m_shaders.at("orbits").u_locs["ViewMatrix"] = -1;
     m_shaders.at("orbits").u_locs["ProjectionMatrix"] = -1;
 
@@ -737,112 +1168,74 @@ void ApplicationSolar::initializeShaderPrograms() {
 
     // =====================================================
     // Assignment 5
-    // store quad shader for working with extra framebuffer
-    m_shaders.emplace("screen_quad", shader_program{ {{GL_VERTEX_SHADER, m_resource_path + "shaders/screen_quad.vert"},
-                                             {GL_FRAGMENT_SHADER, m_resource_path + "shaders/screen_quad.frag"}} });
-
-    m_shaders.at("screen_quad").u_locs["screen_Texture"] = -1;
-    m_shaders.at("screen_quad").u_locs["horizontal_Mirroring"] = 0;
-    m_shaders.at("screen_quad").u_locs["vertical_Mirroring"] = 0;
-    m_shaders.at("screen_quad").u_locs["greyscale_mode"] = 0;
-    m_shaders.at("screen_quad").u_locs["blur_mode"] = 0;
-    m_shaders.at("screen_quad").u_locs["texture_Size"] = -1;
+    // post processing chain, applied in this order
+    // bloom and tone mapping come first, the following effects work on displayable colors
+    post_process.addEffect(std::make_shared<BloomEffect>("bloom", 6));
+    post_process.addEffect(std::make_shared<ToneMapEffect>("tone mapping", scene_format != GL_RGB8));
+    post_process.addEffect(std::make_shared<FxaaEffect>("fxaa"));
+    post_process.addEffect(std::make_shared<GaussianBlurEffect>("blur", 8));
+    post_process.addEffect(std::make_shared<PixelEffect>("horizontal mirroring", "HORIZONTAL_MIRRORING"));
+    post_process.addEffect(std::make_shared<PixelEffect>("vertical mirroring", "VERTICAL_MIRRORING"));
+    post_process.addEffect(std::make_shared<PixelEffect>("greyscale", "GREYSCALE"));
+    updatePostProcessing();
     // =====================================================
 }
 
+void ApplicationSolar::updatePostProcessing() {
+    // merged effect combinations are compiled on first use, or loaded from the binary cache
+    for (auto const& name : post_process.build(m_shaders)) {
+        loadShaderProgram(name, false);
+    }
+    post_process.uploadUniforms(m_shaders, glm::uvec2{img_width, img_height});
+}
+
+void ApplicationSolar::togglePostEffect(std::string const& name) {
+    auto effect = post_process.getEffect(name);
+    effect->setEnabled(!effect->getEnabled());
+    updatePostProcessing();
+}
+
 // load models
 void ApplicationSolar::initializeGeometry() {
+    // suballocated in the shared buffers of the registry, uploaded on first bind
     model planet_model = model_loader::obj(m_resource_path + "models/sphere.obj", model::NORMAL | model::TEXCOORD);
-
-    // generate vertex array object
-    glGenVertexArrays(1, &planet_object.vertex_AO);
-    // bind the array for attaching buffers
-    glBindVertexArray(planet_object.vertex_AO);
-
-    // generate generic buffer
-    glGenBuffers(1, &planet_object.vertex_BO);
-    // bind this as an vertex array buffer containing all attributes
-    glBindBuffer(GL_ARRAY_BUFFER, planet_object.vertex_BO);
-    // configure currently bound array buffer
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * planet_model.data.size(), planet_model.data.data(), GL_STATIC_DRAW);
-
-    // activate first attribute on gpu
-    glEnableVertexAttribArray(0);
-    // first attribute is 3 floats with no offset & stride
-    glVertexAttribPointer(0, model::POSITION.components, model::POSITION.type, GL_FALSE, planet_model.vertex_bytes, planet_model.offsets[model::POSITION]);
-    // activate second attribute on gpu
-    glEnableVertexAttribArray(1);
-    // second attribute is 3 floats with no offset & stride
-    glVertexAttribPointer(1, model::NORMAL.components, model::NORMAL.type, GL_FALSE, planet_model.vertex_bytes, planet_model.offsets[model::NORMAL]);
-    // activate third attribute on gpu
-    glEnableVertexAttribArray(2);
-    // second attribute is 2 floats with no offset & stride
-    glVertexAttribPointer(2, model::TEXCOORD.components, model::TEXCOORD.type, GL_FALSE, planet_model.vertex_bytes, planet_model.offsets[model::TEXCOORD]);
-
-    // generate generic buffer
-    glGenBuffers(1, &planet_object.element_BO);
-    // bind this as an vertex array buffer containing all attributes
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, planet_object.element_BO);
-    // configure currently bound array buffer
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, model::INDEX.size * planet_model.indices.size(), planet_model.indices.data(), GL_STATIC_DRAW);
-
-    // store type of primitive to draw
-    planet_object.draw_mode = GL_TRIANGLES;
-    // transfer number of indices to model object
-    planet_object.num_elements = GLsizei(planet_model.indices.size());
-
-    ////////////////
+    sphere_mesh_ = meshes_.add(planet_model);
 
     // add skybox model
     model skybox_model = model_loader::obj(m_resource_path + "models/skybox.obj");
-    // starting with VAO
-    glGenVertexArrays(1, &skybox_object.vertex_AO);
-    // bind that
-    glBindVertexArray(skybox_object.vertex_AO);
-    // generic buffer
-    glGenBuffers(1, &skybox_object.vertex_BO);
-    // again : binding as vertex array buffer with all attributes
-    glBindBuffer(GL_ARRAY_BUFFER, skybox_object.vertex_BO);
-    // configuration
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * skybox_model.data.size(), skybox_model.data.data(), GL_STATIC_DRAW);
-    // activation of first attribute on gpu
-    glEnableVertexAttribArray(0);
-    // first attribute is 3 floats with no offset & stride
-    glVertexAttribPointer(0, model::POSITION.components, model::POSITION.type, GL_FALSE, skybox_model.vertex_bytes,
-                          skybox_model.offsets[model::POSITION]);
-    // generate generic buffer
-    glGenBuffers(1, &skybox_object.element_BO);
-    // bind as an vertex array buffer containing all attributes
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, skybox_object.element_BO);
-    // configure currently bound array buffer
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, model::INDEX.size * skybox_model.indices.size(), skybox_model.indices.data(),
-                 GL_STATIC_DRAW);
-    // store type of primitive to draw
-    skybox_object.draw_mode = GL_TRIANGLES;
-    // transfer number of indices to model object
-    skybox_object.num_elements = GLsizei(skybox_model.indices.size());
+    skybox_mesh_ = meshes_.add(skybox_model);
+    meshes_.upload();
+
+    std::cout << "Meshes: " << meshes_.getMeshCount() << ", "
+              << (meshes_.getIndirectSupport() ? "multi draw indirect" : "one draw per command") << std::endl;
 }
 
 ///////////////////////////// callback functions for window events ////////////
 // handle key input
 void ApplicationSolar::keyCallback(int key, int action, int mods) {
+    // movement is only collected here, the camera is moved once per frame in update
     if (key == GLFW_KEY_W  && (action == GLFW_PRESS || action == GLFW_REPEAT)) {
-        m_view_transform = glm::translate(m_view_transform, glm::fvec3{0.0f, 0.0f, -0.1f});
+        pending_translation_.z -= camera_step;
     }
     else if (key == GLFW_KEY_S  && (action == GLFW_PRESS || action == GLFW_REPEAT)) {
-        m_view_transform = glm::translate(m_view_transform, glm::fvec3{0.0f, 0.0f, 0.1f});
+        pending_translation_.z += camera_step;
     }
     else if (key == GLFW_KEY_A  && (action == GLFW_PRESS || action == GLFW_REPEAT)) {
-        m_view_transform = glm::translate(m_view_transform, glm::fvec3{-0.1f, 0.0f, 0.0f});
+        pending_translation_.x -= camera_step;
     }
     else if (key == GLFW_KEY_D  && (action == GLFW_PRESS || action == GLFW_REPEAT)) {
-        m_view_transform = glm::translate(m_view_transform, glm::fvec3{0.1f, 0.0f, 0.0f});
+        pending_translation_.x += camera_step;
     }
     else if (key == GLFW_KEY_SPACE  && (action == GLFW_PRESS || action == GLFW_REPEAT)) {
-        m_view_transform = glm::translate(m_view_transform, glm::fvec3{0.0f, 0.1f, 0.0f});
+        pending_translation_.y += camera_step;
     }
     else if (key == GLFW_KEY_LEFT_SHIFT  && (action == GLFW_PRESS || action == GLFW_REPEAT)) {
-        m_view_transform = glm::translate(m_view_transform, glm::fvec3{0.0f, -0.1f, 0.0f});
+        pending_translation_.y -= camera_step;
+    }
+    // camera follows input smoothly or jumps to it
+    else if (key == GLFW_KEY_C && (action == GLFW_PRESS)) {
+        camera_smoothing_ = !camera_smoothing_;
+        std::cout << "Camera smoothing " << (camera_smoothing_ ? "on" : "off") << std::endl;
     }
     /*
     //    else if (key == GLFW_KEY_1 && (action == GLFW_PRESS || action == GLFW_REPEAT)) {
@@ -860,101 +1253,221 @@ void ApplicationSolar::keyCallback(int key, int action, int mods) {
     // =====================================================
     // Assignment 5
     // to stop the movement and stay in position
+    // read while preparing a frame, so the worker is waited for
     else if (key == GLFW_KEY_3 && (action == GLFW_PRESS)) {
+        frame_pipeline_.wait();
         moving_time = !moving_time;
+        ++state_revision_;
+    }
+    // switch between scripted orbits and gravitational simulation
+    else if (key == GLFW_KEY_N && (action == GLFW_PRESS)) {
+        frame_pipeline_.wait();
+        ++state_revision_;
+        nbody_mode = !nbody_mode;
+        if (nbody_mode) {
+            startNBody();
+        }
+    }
+    // switch between forward and deferred shading of the planets
+    else if (key == GLFW_KEY_G && (action == GLFW_PRESS)) {
+        deferred_mode = !deferred_mode;
+        initializeFrameBuffer(img_width, img_height);
+        std::cout << (deferred_mode ? "Deferred" : "Forward") << " shading" << std::endl;
+        reportRenderTargets();
+    }
+    // scene format, clamped to [0, 1] or high dynamic range mapped by the adapted exposure
+    else if (key == GLFW_KEY_H && (action == GLFW_PRESS)) {
+        scene_format = scene_format == GL_RGB8 ? GL_RGBA16F : scene_format == GL_RGBA16F ? GL_R11F_G11F_B10F : GL_RGB8;
+        initializeFrameBuffer(img_width, img_height);
+        post_process.getEffect("tone mapping")->setEnabled(scene_format != GL_RGB8);
+        // bloom output is still above 1 when it reaches the tone mapping
+        post_process.setFormat(scene_format == GL_RGB8 ? GL_RGB8 : GL_R11F_G11F_B10F);
+        updatePostProcessing();
+        std::cout << "Scene format "
+                  << (scene_format == GL_RGB8 ? "RGB8" : scene_format == GL_RGBA16F ? "RGBA16F" : "R11F_G11F_B10F")
+                  << std::endl;
+        reportRenderTargets();
+    }
+    // exposure compensation of the tone mapping in half stops
+    else if ((key == GLFW_KEY_LEFT_BRACKET || key == GLFW_KEY_RIGHT_BRACKET)
+             && (action == GLFW_PRESS || action == GLFW_REPEAT)) {
+        auto tone_map = std::static_pointer_cast<ToneMapEffect>(post_process.getEffect("tone mapping"));
+        tone_map->setExposure(tone_map->getExposure() + (key == GLFW_KEY_RIGHT_BRACKET ? 0.5f : -0.5f));
+        std::cout << "Exposure " << tone_map->getExposure() << " EV" << std::endl;
+    }
+    // anti-aliasing of the forward path, 1, 2, 4 and 8 samples per pixel up to what the driver supports
+    else if (key == GLFW_KEY_M && (action == GLFW_PRESS)) {
+        msaa_samples = msaa_samples >= std::min(8, RenderTargetPool::getMaxSamples()) ? 1 : msaa_samples * 2;
+        initializeFrameBuffer(img_width, img_height);
+        std::cout << "MSAA " << msaa_samples << "x" << (deferred_mode && msaa_samples > 1 ? ", off while deferred" : "")
+                  << std::endl;
+        reportRenderTargets();
+    }
+    // cheaper alternative working on the final image
+    else if (key == GLFW_KEY_F && (action == GLFW_PRESS)) {
+        togglePostEffect("fxaa");
+    }
+    // resolution following the frame time, or always the window size
+    else if (key == GLFW_KEY_K && (action == GLFW_PRESS)) {
+        resolution_.setEnabled(!resolution_.getEnabled());
+        std::cout << "Dynamic resolution " << (resolution_.getEnabled() ? "on" : "off") << std::endl;
+    }
+    // frame time budget in milliseconds
+    else if ((key == GLFW_KEY_COMMA || key == GLFW_KEY_PERIOD) && (action == GLFW_PRESS || action == GLFW_REPEAT)) {
+        resolution_.setBudget(resolution_.getBudget() + (key == GLFW_KEY_PERIOD ? 1.0 : -1.0));
+        std::cout << "Frame budget " << resolution_.getBudget() << " ms" << std::endl;
+    }
+    // early depth rejection and its effect on the shaded fragments
+    else if (key == GLFW_KEY_P && (action == GLFW_PRESS)) {
+        depth_prepass = !depth_prepass;
+        std::cout << "Depth pre-pass " << (depth_prepass ? "on" : "off") << std::endl;
+    }
+    else if (key == GLFW_KEY_O && (action == GLFW_PRESS)) {
+        overdraw_report = !overdraw_report;
+    }
+    // record jobs while on, written as chrome trace when switched off
+    else if (key == GLFW_KEY_J && (action == GLFW_PRESS)) {
+        JobSystem& jobs = JobSystem::shared();
+        jobs.setTracing(!jobs.getTracing());
+        if (jobs.getTracing()) {
+            std::cout << "Tracing jobs on " << jobs.getWorkerCount() << " workers" << std::endl;
+        }
+        else {
+            try {
+                jobs.writeTrace(job_trace_file_name);
+                std::cout << "Job trace written to " << job_trace_file_name << std::endl;
+            }
+            catch (std::exception& error) {
+                std::cerr << error.what() << std::endl;
+            }
+        }
+    }
+    // next frame prepared as a job while this one is submitted, or both in turn
+    // waits for the running preparation itself
+    else if (key == GLFW_KEY_T && (action == GLFW_PRESS)) {
+        frame_pipeline_.setThreaded(!frame_pipeline_.getThreaded());
+        std::cout << "Frame preparation " << (frame_pipeline_.getThreaded() ? "as a job" : "serial") << std::endl;
     }
     // post-processing
     else if (key == GLFW_KEY_7 && (action == GLFW_PRESS)) {
-        greyscale_mode = !greyscale_mode;
+        togglePostEffect("greyscale");
     }
     else if (key == GLFW_KEY_8 && (action == GLFW_PRESS)) {
-        horizontal_mirroring = !horizontal_mirroring;
+        togglePostEffect("horizontal mirroring");
     }
     else if (key == GLFW_KEY_9 && (action == GLFW_PRESS)) {
-        vertical_mirroring = !vertical_mirroring;
+        togglePostEffect("vertical mirroring");
     }
     else if (key == GLFW_KEY_0 && (action == GLFW_PRESS)) {
-        blur_mode = !blur_mode;
+        togglePostEffect("blur");
+    }
+    else if (key == GLFW_KEY_B && (action == GLFW_PRESS)) {
+        togglePostEffect("bloom");
+    }
+    // blur radius, limited by the taps the shader was compiled for
+    else if ((key == GLFW_KEY_EQUAL || key == GLFW_KEY_KP_ADD || key == GLFW_KEY_MINUS || key == GLFW_KEY_KP_SUBTRACT)
+             && (action == GLFW_PRESS || action == GLFW_REPEAT)) {
+        auto blur = std::static_pointer_cast<GaussianBlurEffect>(post_process.getEffect("blur"));
+        bool increase = key == GLFW_KEY_EQUAL || key == GLFW_KEY_KP_ADD;
+        blur->setRadius(increase ? blur->getRadius() + 1 : blur->getRadius() - 1);
+        post_process.uploadUniforms(m_shaders, glm::uvec2{img_width, img_height});
     }
-    // =====================================================
-
-    glUseProgram(m_shaders.at("planet").handle);
-    uploadView("planet");
-    uploadProjection("planet");
-    glUseProgram(m_shaders.at("star").handle);
-    uploadView("star");
-    uploadProjection("star");
-    glUseProgram(m_shaders.at("orbits").handle);
-    uploadView("orbits");
-    uploadProjection("orbits");
-    glUseProgram(m_shaders.at("skybox").handle);
-    uploadView("skybox");
-    uploadProjection("skybox");
-    // =====================================================
-    // Assignment 5
-    glUseProgram(m_shaders.at("screen_quad").handle);
-    uploadView("screen_quad");
     // =====================================================
 }
 
 //handle delta mouse movement input
 void ApplicationSolar::mouseCallback(double pos_x, double pos_y) {
     // mouse handling
+    // many events per frame only add up, rotating and uploading happens once in update
+    pending_rotation_.x += float(pos_x) * mouse_sensitivity;
+    pending_rotation_.y += float(pos_y) * mouse_sensitivity;
+}
 
-    float horizontal_rotate = float(pos_x / 20); //divide to slow down
-    float vertical_rotate = float(pos_y / 20);
+//handle resizing
+void ApplicationSolar::resizeCallback(unsigned width, unsigned height) {
+    // minimized window, keep targets of the last size
+    if (width == 0 || height == 0) {
+        return;
+    }
+    // a drag reports many sizes, targets are only reallocated for the last one in update
+    pending_size_ = glm::uvec2{width, height};
+}
+
+void ApplicationSolar::applyInput() {
+    double now = glfwGetTime();
+    float seconds = float(std::min(now - last_camera_time_, 0.1));
+    last_camera_time_ = now;
 
     //glm rotate transforms a matrix 4x4, created from axis of 3 scalars and angle in degree (glm::radians). Scalars define the axis for rotation
-    m_view_transform = glm::rotate(m_view_transform,
-                                   glm::radians(vertical_rotate),
-                                   glm::vec3{1.0f, 0.0f, 0.0f});
-    m_view_transform = glm::rotate(m_view_transform,
-                                   glm::radians(horizontal_rotate),
-                                   glm::vec3{0.0f, 1.0f, 0.0f});
+    bool moved = pending_rotation_ != glm::fvec2{0.0f} || pending_translation_ != glm::fvec3{0.0f};
+    if (moved) {
+        target_view_transform_ = glm::rotate(target_view_transform_, glm::radians(pending_rotation_.y), glm::fvec3{1.0f, 0.0f, 0.0f});
+        target_view_transform_ = glm::rotate(target_view_transform_, glm::radians(pending_rotation_.x), glm::fvec3{0.0f, 1.0f, 0.0f});
+        target_view_transform_ = glm::translate(target_view_transform_, pending_translation_);
+        pending_rotation_ = glm::fvec2{0.0f};
+        pending_translation_ = glm::fvec3{0.0f};
+    }
 
-    glUseProgram(m_shaders.at("planet").handle);
-    uploadView("planet");
-    uploadProjection("planet");
-    glUseProgram(m_shaders.at("star").handle);
-    uploadView("star");
-    uploadProjection("star");
-    glUseProgram(m_shaders.at("orbits").handle);
-    uploadView("orbits");
-    uploadProjection("orbits");
-    glUseProgram(m_shaders.at("skybox").handle);
-    uploadView("skybox");
-    uploadProjection("skybox");
-    // =====================================================
-    // Assignment 5
-    glUseProgram(m_shaders.at("screen_quad").handle);
-    uploadView("screen_quad");
-    // =====================================================
+    // follow the target with exponential smoothing, position linearly and orientation along the shortest arc
+    if (m_view_transform != target_view_transform_) {
+        glm::fquat current{glm::quat_cast(m_view_transform)};
+        glm::fquat target{glm::quat_cast(target_view_transform_)};
+        glm::fvec3 current_position{m_view_transform[3]};
+        glm::fvec3 target_position{target_view_transform_[3]};
+        float factor = camera_smoothing_ ? 1.0f - std::exp(-seconds * camera_follow_rate) : 1.0f;
+        glm::fvec3 position = glm::mix(current_position, target_position, factor);
+        glm::fquat orientation = glm::slerp(current, target, factor);
+        // close enough to be invisible, stop interpolating so idle frames skip the upload
+        if (glm::distance(position, target_position) < 1e-4f && std::abs(glm::dot(orientation, target)) > 1.0f - 1e-7f) {
+            m_view_transform = target_view_transform_;
+        }
+        else {
+            m_view_transform = glm::mat4_cast(orientation);
+            m_view_transform[3] = glm::fvec4{position, 1.0f};
+            m_frame_pacer.requestRedraw();
+        }
+    }
+
+    bool resized = pending_size_ != glm::uvec2{0};
+    if (resized) {
+        resize(pending_size_.x, pending_size_.y);
+        pending_size_ = glm::uvec2{0};
+    }
+    // the view is uploaded with the frame prepared for it
+    if (resized) {
+        uploadCamera(uploaded_view_transform_, true);
+    }
 }
 
-//handle resizing
-void ApplicationSolar::resizeCallback(unsigned width, unsigned height) {
+void ApplicationSolar::uploadCamera(glm::fmat4 const& view_transform, bool projection) const {
+    // vertices are transformed in camera space, so camera transform must be inverted
+    glm::fmat4 view_matrix = glm::inverse(view_transform);
+    uploaded_view_transform_ = view_transform;
+    // also called from update, after the post chain or a resize bound programs past the cache
+    state_.invalidate();
+    for (std::string const& name : camera_programs) {
+        shader_program const& program = m_shaders.at(name);
+        state_.useProgram(program.handle);
+        glUniformMatrix4fv(program.u_locs.at("ViewMatrix"), 1, GL_FALSE, glm::value_ptr(view_matrix));
+        if (projection) {
+            glUniformMatrix4fv(program.u_locs.at("ProjectionMatrix"), 1, GL_FALSE, glm::value_ptr(m_view_projection));
+        }
+    }
+}
+
+void ApplicationSolar::resize(unsigned width, unsigned height) {
     // recalculate projection matrix for new aspect ration
     m_view_projection = utils::calculate_projection_matrix(float(width) / float(height));
-    // upload new projection matrices
-    glUseProgram(m_shaders.at("planet").handle);
-    uploadView("planet");
-    uploadProjection("planet");
-    glUseProgram(m_shaders.at("star").handle);
-    uploadView("star");
-    uploadProjection("star");
-    glUseProgram(m_shaders.at("orbits").handle);
-    uploadView("orbits");
-    uploadProjection("orbits");
-    glUseProgram(m_shaders.at("skybox").handle);
-    uploadView("skybox");
-    uploadProjection("skybox");
     // =====================================================
     // Assignment 5
-    glUseProgram(m_shaders.at("screen_quad").handle);
-    uploadView("screen_quad");
     initializeFrameBuffer(width, height);
     img_width = width;
     img_height = height;
+    // ring tessellation depends on viewport height
+    uploadOrbitTessellation();
+    // texel size changed
+    post_process.uploadUniforms(m_shaders, glm::uvec2{img_width, img_height});
+    reportRenderTargets();
     // =====================================================
 }
 
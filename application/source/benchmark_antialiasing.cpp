@@ -0,0 +1,191 @@
+#include "window_handler.hpp"
+#include "render_target_pool.hpp"
+#include "post_process.hpp"
+#include "shader_loader.hpp"
+#include "utils.hpp"
+
+#include <glbinding/gl/gl.h>
+// use gl definitions from glbinding
+using namespace gl;
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+static const glm::uvec2 resolution{1280, 720};
+
+// thin spokes and line loops like planet silhouettes and orbits, many edges at every angle
+struct test_scene {
+    GLuint vertex_array = 0;
+    GLuint vertex_buffer = 0;
+    GLsizei triangle_vertices = 0;
+    GLsizei loop_count = 0;
+    GLsizei loop_vertices = 0;
+};
+
+static test_scene make_scene() {
+    std::mt19937 generator{7};
+    std::uniform_real_distribution<float> unit{0.0f, 1.0f};
+    // position and color
+    std::vector<GLfloat> vertices{};
+    auto add = [&vertices](float x, float y, float z, glm::fvec3 const& color) {
+        vertices.insert(vertices.end(), {x, y, z, color.r, color.g, color.b});
+    };
+
+    test_scene scene{};
+    float aspect = float(resolution.y) / float(resolution.x);
+    for (int i = 0; i < 720; ++i) {
+        float angle = float(i) * 0.00872665f;
+        glm::fvec3 color{unit(generator), unit(generator), unit(generator)};
+        add(0.0f, 0.0f, unit(generator), color);
+        add(std::cos(angle) * aspect, std::sin(angle), 0.5f, color);
+        add(std::cos(angle + 0.002f) * aspect, std::sin(angle + 0.002f), 0.5f, color);
+    }
+    scene.triangle_vertices = GLsizei(vertices.size() / 6);
+
+    scene.loop_count = 64;
+    scene.loop_vertices = 256;
+    for (GLsizei loop = 0; loop < scene.loop_count; ++loop) {
+        float radius = 0.05f + 0.9f * float(loop) / float(scene.loop_count);
+        float tilt = 0.3f + 0.7f * unit(generator);
+        for (GLsizei i = 0; i < scene.loop_vertices; ++i) {
+            float angle = 6.28318531f * float(i) / float(scene.loop_vertices);
+            add(std::cos(angle) * radius * aspect, std::sin(angle) * radius * tilt, 0.0f, glm::fvec3{1.0f});
+        }
+    }
+
+    glGenVertexArrays(1, &scene.vertex_array);
+    glBindVertexArray(scene.vertex_array);
+    glGenBuffers(1, &scene.vertex_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, scene.vertex_buffer);
+    glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(sizeof(GLfloat) * vertices.size()), vertices.data(), GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, GLsizei(6 * sizeof(GLfloat)), nullptr);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, GLsizei(6 * sizeof(GLfloat)), (void*)(3 * sizeof(GLfloat)));
+    glBindVertexArray(0);
+    return scene;
+}
+
+static void draw_scene(test_scene const& scene, GLuint program, GLuint framebuffer) {
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glViewport(0, 0, GLsizei(resolution.x), GLsizei(resolution.y));
+    glEnable(GL_DEPTH_TEST);
+    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glUseProgram(program);
+    glBindVertexArray(scene.vertex_array);
+    glDrawArrays(GL_TRIANGLES, 0, scene.triangle_vertices);
+    for (GLsizei loop = 0; loop < scene.loop_count; ++loop) {
+        glDrawArrays(GL_LINE_LOOP, scene.triangle_vertices + loop * scene.loop_vertices, scene.loop_vertices);
+    }
+}
+
+// milliseconds per frame, waiting for the gpu to finish, repeated for at least half a second
+template<typename Frame>
+static double measure(Frame frame) {
+    // warm up, first frames allocate driver resources
+    for (int i = 0; i < 10; ++i) {
+        frame();
+    }
+    glFinish();
+    unsigned frames = 0;
+    auto start = std::chrono::steady_clock::now();
+    double seconds = 0.0;
+    while (seconds < 0.5 || frames < 10) {
+        frame();
+        ++frames;
+        if (frames % 10 == 0) {
+            glFinish();
+            seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+    }
+    return seconds * 1e3 / double(frames);
+}
+
+int main(int argc, char* argv[]) {
+    std::string resource_path = utils::read_resource_path(argc, argv);
+    GLFWwindow* window = window_handler::initialize(resolution, 3, 2);
+
+    test_scene scene = make_scene();
+    GLuint program = shader_loader::program({{GL_VERTEX_SHADER, resource_path + "shaders/vao.vert"},
+                                             {GL_FRAGMENT_SHADER, resource_path + "shaders/vao.frag"}});
+    glUseProgram(program);
+    glm::fmat4 identity{};
+    for (char const* matrix : {"ModelMatrix", "ViewMatrix", "ProjectionMatrix"}) {
+        glUniformMatrix4fv(utils::glGetUniformLocation(program, matrix), 1, GL_FALSE, glm::value_ptr(identity));
+    }
+
+    RenderTargetPool targets{};
+    render_target* scene_target = targets.acquire(resolution, GL_RGB8, GL_DEPTH_COMPONENT24);
+    render_target* output_target = targets.acquire(resolution, GL_RGB8);
+
+    // chain with only fxaa, compiled like the application does
+    std::map<std::string, shader_program> shaders{};
+    PostProcessChain fxaa{resource_path + "shaders/"};
+    fxaa.addEffect(std::make_shared<FxaaEffect>("fxaa", true));
+    for (auto const& name : fxaa.build(shaders)) {
+        shader_program& added = shaders.at(name);
+        added.handle = shader_loader::program(added.shader_paths, added.defines);
+        for (auto& uniform : added.u_locs) {
+            uniform.second = utils::glGetUniformLocation(added.handle, uniform.first.c_str());
+        }
+    }
+    fxaa.uploadUniforms(shaders, resolution);
+
+    std::cout << resolution.x << "x" << resolution.y << ", " << scene.triangle_vertices / 3 << " triangles, "
+              << scene.loop_count << " line loops" << std::endl;
+    std::cout << std::setw(12) << "mode" << std::setw(12) << "ms/frame" << std::setw(12) << "relative"
+              << std::setw(12) << "MiB" << std::endl;
+
+    // no anti-aliasing as reference
+    double reference = measure([&] { draw_scene(scene, program, scene_target->framebuffer.handle); });
+    auto print = [reference](std::string const& mode, double milliseconds, std::size_t bytes) {
+        std::cout << std::setw(12) << mode << std::fixed << std::setprecision(3) << std::setw(12) << milliseconds
+                  << std::setprecision(2) << std::setw(12) << milliseconds / reference
+                  << std::setw(12) << float(bytes) / (1024.0f * 1024.0f) << std::endl;
+    };
+    print("none", reference, targets.getMemoryUsage());
+
+    // scene drawn with several samples, resolved into the single sample target
+    for (GLsizei samples = 2; samples <= std::min(8, RenderTargetPool::getMaxSamples()); samples *= 2) {
+        render_target* multisample = targets.acquire(resolution, GL_RGB8, GL_DEPTH_COMPONENT24, samples);
+        double milliseconds = measure([&] {
+            draw_scene(scene, program, multisample->framebuffer.handle);
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, multisample->framebuffer.handle);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, scene_target->framebuffer.handle);
+            glBlitFramebuffer(0, 0, GLint(resolution.x), GLint(resolution.y), 0, 0, GLint(resolution.x),
+                              GLint(resolution.y), GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        });
+        print("MSAA " + std::to_string(samples) + "x", milliseconds, targets.getMemoryUsage());
+        targets.release(multisample);
+        targets.trim();
+    }
+
+    // single sample scene filtered in one screen pass
+    double milliseconds = measure([&] {
+        draw_scene(scene, program, scene_target->framebuffer.handle);
+        fxaa.render(shaders, scene_target->framebuffer.color_handle, output_target->framebuffer.handle, resolution);
+    });
+    print("FXAA", milliseconds, targets.getMemoryUsage() + fxaa.getPool().getMemoryUsage());
+
+    for (auto const& pair : shaders) {
+        glDeleteProgram(pair.second.handle);
+    }
+    glDeleteProgram(program);
+    glDeleteBuffers(1, &scene.vertex_buffer);
+    glDeleteVertexArrays(1, &scene.vertex_array);
+    targets.clear();
+    fxaa.trimTargets();
+    window_handler::close_and_quit(window, EXIT_SUCCESS);
+}
@@ -0,0 +1,79 @@
+#include "nbody.hpp"
+
+#include <glm/glm.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+// energy is summed directly, only affordable for small systems
+static const std::size_t max_energy_bodies = 4096;
+
+// bodies on circular orbits in a thin disc around a heavy center
+static void make_disc(NBodySimulation& simulation, std::size_t count) {
+    std::mt19937 generator{42};
+    std::uniform_real_distribution<float> radius_distribution{0.5f, 10.0f};
+    std::uniform_real_distribution<float> angle_distribution{0.0f, 6.28318531f};
+    std::normal_distribution<float> height_distribution{0.0f, 0.05f};
+
+    float central_mass = 1.0f;
+    float body_mass = 0.1f / float(count);
+    simulation.addBody(glm::fvec3{0.0f}, glm::fvec3{0.0f}, central_mass);
+    for (std::size_t i = 1; i < count; ++i) {
+        float radius = radius_distribution(generator);
+        float angle = angle_distribution(generator);
+        glm::fvec3 position{radius * std::cos(angle), height_distribution(generator), radius * std::sin(angle)};
+        float speed = std::sqrt(central_mass / radius);
+        glm::fvec3 velocity{-speed * std::sin(angle), 0.0f, speed * std::cos(angle)};
+        simulation.addBody(position, velocity, body_mass);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    // largest system, doubled up from 1024 bodies
+    std::size_t max_bodies = argc > 1 ? std::size_t(std::atol(argv[1])) : 65536;
+    float dt = 0.01f;
+
+    std::cout << std::setw(10) << "bodies" << std::setw(10) << "threads" << std::setw(12) << "steps/s"
+              << std::setw(12) << "cells" << std::setw(16) << "energy drift" << std::endl;
+
+    for (std::size_t bodies = 1024; bodies <= max_bodies; bodies *= 4) {
+        unsigned hardware = NBodySimulation{}.getThreadCount();
+        for (unsigned threads : {1u, hardware}) {
+            NBodySimulation simulation{};
+            simulation.setThreadCount(threads);
+            make_disc(simulation, bodies);
+            bool energy = bodies <= max_energy_bodies;
+            double initial_energy = energy ? simulation.getEnergy() : 0.0;
+
+            // first step also builds the initial forces
+            simulation.step(dt);
+
+            // run for at least a second
+            unsigned steps = 0;
+            auto start = std::chrono::steady_clock::now();
+            double seconds = 0.0;
+            while (seconds < 1.0 || steps < 3) {
+                simulation.step(dt);
+                ++steps;
+                seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            }
+
+            std::cout << std::setw(10) << bodies << std::setw(10) << threads
+                      << std::setw(12) << std::fixed << std::setprecision(1) << double(steps) / seconds
+                      << std::setw(12) << simulation.getCellCount();
+            if (energy) {
+                double drift = std::abs((simulation.getEnergy() - initial_energy) / initial_energy);
+                std::cout << std::setw(16) << std::scientific << std::setprecision(2) << drift;
+            }
+            std::cout << std::endl;
+
+            if (threads == hardware) {
+                break;
+            }
+        }
+    }
+}
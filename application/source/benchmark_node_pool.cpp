@@ -0,0 +1,89 @@
+#include "allocation_counter.hpp"
+#include "node.hpp"
+#include "node_pool.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+typedef std::chrono::steady_clock benchmark_clock;
+
+static double milliseconds_since(benchmark_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(benchmark_clock::now() - start).count();
+}
+
+struct build_result {
+    double build_time;
+    double teardown_time;
+    std::size_t allocations;
+};
+
+static void print(char const* name, build_result const& result, std::size_t nodes) {
+    std::cout << std::setw(12) << name << std::fixed << std::setprecision(1)
+              << std::setw(12) << result.build_time << std::setw(14) << result.teardown_time;
+    if (allocation_counter::enabled()) {
+        std::cout << std::setw(16) << std::setprecision(2) << double(result.allocations) / double(nodes);
+    }
+    std::cout << std::endl;
+}
+
+// holder and body pairs below one root, like the solar system builds them
+template<typename Create>
+static std::shared_ptr<Node> build(std::shared_ptr<Node> const& root, std::size_t bodies, Create create) {
+    for (std::size_t i = 0; i < bodies; ++i) {
+        std::shared_ptr<Node> holder = create("holder", root);
+        root->addChild(holder);
+        holder->addChild(create("body", holder));
+    }
+    return root;
+}
+
+static build_result measure_shared(std::size_t bodies) {
+    build_result result{};
+    std::size_t allocations = allocation_counter::count();
+    auto start = benchmark_clock::now();
+    std::shared_ptr<Node> root = build(std::make_shared<Node>(), bodies, [](char const* name, std::shared_ptr<Node> const& parent) {
+        return std::make_shared<Node>(name, parent, glm::fmat4{1.0f});
+    });
+    result.build_time = milliseconds_since(start);
+    result.allocations = allocation_counter::count() - allocations;
+    start = benchmark_clock::now();
+    root.reset();
+    result.teardown_time = milliseconds_since(start);
+    return result;
+}
+
+static build_result measure_pool(std::size_t bodies) {
+    build_result result{};
+    NodePool<Node> pool{};
+    std::size_t allocations = allocation_counter::count();
+    auto start = benchmark_clock::now();
+    pool.reserve(2 * bodies + 1);
+    std::shared_ptr<Node> root = build(pool.create(), bodies, [&pool](char const* name, std::shared_ptr<Node> const& parent) {
+        return pool.create(name, parent, glm::fmat4{1.0f});
+    });
+    result.build_time = milliseconds_since(start);
+    result.allocations = allocation_counter::count() - allocations;
+    start = benchmark_clock::now();
+    root.reset();
+    pool.clear();
+    result.teardown_time = milliseconds_since(start);
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t bodies = argc > 1 ? std::size_t(std::atol(argv[1])) : 1000000;
+    std::size_t nodes = 2 * bodies + 1;
+
+    std::cout << nodes << " nodes" << std::endl;
+    std::cout << std::setw(12) << "allocation" << std::setw(12) << "build ms" << std::setw(14) << "teardown ms";
+    if (allocation_counter::enabled()) {
+        std::cout << std::setw(16) << "allocs per node";
+    }
+    std::cout << std::endl;
+    print("make_shared", measure_shared(bodies), nodes);
+    print("pool", measure_pool(bodies), nodes);
+    return EXIT_SUCCESS;
+}
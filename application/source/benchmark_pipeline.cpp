@@ -0,0 +1,191 @@
+#include "window_handler.hpp"
+#include "frame_pipeline.hpp"
+#include "shader_loader.hpp"
+#include "kepler.hpp"
+#include "transform_batch.hpp"
+#include "utils.hpp"
+
+#include <glbinding/gl/gl.h>
+// use gl definitions from glbinding
+using namespace gl;
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+static const glm::uvec2 resolution{640, 480};
+
+// orbiting bodies moved every frame like the planets of the application
+struct test_scene {
+    kepler::orbit_batch orbits{};
+    std::vector<glm::fmat4> placements{};
+    std::vector<glm::fmat4> locals{};
+    glm::fmat4 view_matrix{};
+    float time = 0.0f;
+};
+
+// what the gl side needs to draw a frame, bodies nearest first
+struct frame_packet {
+    std::vector<glm::fmat4> models{};
+    std::vector<glm::fmat4> normals{};
+    std::vector<float> depths{};
+    std::vector<std::size_t> order{};
+};
+
+static test_scene make_scene(std::size_t bodies) {
+    std::mt19937 generator{7};
+    std::uniform_real_distribution<float> unit{0.0f, 1.0f};
+    test_scene scene{};
+    for (std::size_t i = 0; i < bodies; ++i) {
+        orbital_elements elements{};
+        elements.semi_major_axis = 1.0f + 20.0f * unit(generator);
+        elements.eccentricity = 0.5f * unit(generator);
+        elements.inclination = 0.3f * unit(generator);
+        elements.ascending_node = 6.28318531f * unit(generator);
+        elements.periapsis_argument = 6.28318531f * unit(generator);
+        elements.mean_anomaly = 6.28318531f * unit(generator);
+        elements.mean_motion = 0.1f + unit(generator);
+        kepler::add(scene.orbits, elements);
+    }
+    scene.placements.resize(bodies);
+    scene.locals.assign(bodies, glm::scale(glm::fmat4{}, glm::fvec3{0.2f}));
+    scene.view_matrix = glm::inverse(glm::translate(glm::fmat4{}, glm::fvec3{0.0f, 10.0f, 40.0f}));
+    return scene;
+}
+
+// simulation, matrices and draw order, no gl calls
+static void prepare(test_scene& scene, frame_packet& packet) {
+    scene.time += 1.0f / 60.0f;
+    kepler::propagate(scene.orbits, scene.time);
+    std::size_t bodies = scene.placements.size();
+    for (std::size_t i = 0; i < bodies; ++i) {
+        glm::fvec3 position{scene.orbits.x[i], scene.orbits.y[i], scene.orbits.z[i]};
+        scene.placements[i] = glm::rotate(glm::translate(glm::fmat4{}, position), scene.time, glm::fvec3{0.0f, 1.0f, 0.0f});
+    }
+    packet.models.resize(bodies);
+    packet.normals.resize(bodies);
+    packet.depths.resize(bodies);
+    packet.order.resize(bodies);
+    transform_batch::multiply(scene.placements.data(), scene.locals.data(), packet.models.data(), bodies);
+    transform_batch::normal_matrices(scene.view_matrix, packet.models.data(), packet.normals.data(), bodies);
+    for (std::size_t i = 0; i < bodies; ++i) {
+        packet.depths[i] = -(scene.view_matrix * packet.models[i][3]).z;
+        packet.order[i] = i;
+    }
+    std::sort(packet.order.begin(), packet.order.end(), [&packet](std::size_t a, std::size_t b) {
+        return packet.depths[a] < packet.depths[b];
+    });
+}
+
+// one draw with its own uniform upload per body, the driver work the pipeline overlaps
+static void submit(frame_packet const& packet, GLint model_location) {
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    for (std::size_t body : packet.order) {
+        glUniformMatrix4fv(model_location, 1, GL_FALSE, glm::value_ptr(packet.models[body]));
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+    }
+    glFlush();
+}
+
+// milliseconds per frame and per wait for the worker, repeated for at least half a second
+static void measure(FramePipeline& pipeline, std::size_t& pending, frame_packet const* packets, GLint model_location,
+                    double& frame_time, double& wait_time) {
+    auto frame = [&] {
+        // packet kicked last frame is ready, the worker starts on the other one
+        pipeline.wait();
+        std::size_t submitted = pending;
+        pending = 1 - pending;
+        pipeline.kick(pending);
+        submit(packets[submitted], model_location);
+        return pipeline.getWaitTime();
+    };
+    // warm up, first frames allocate driver resources
+    for (int i = 0; i < 10; ++i) {
+        frame();
+    }
+    glFinish();
+    unsigned frames = 0;
+    double waited = 0.0;
+    auto start = std::chrono::steady_clock::now();
+    double seconds = 0.0;
+    while (seconds < 0.5 || frames < 10) {
+        waited += frame();
+        ++frames;
+        if (frames % 10 == 0) {
+            glFinish();
+            seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+    }
+    frame_time = seconds * 1e3 / double(frames);
+    wait_time = waited / double(frames);
+}
+
+int main(int argc, char* argv[]) {
+    std::string resource_path = utils::read_resource_path(argc, argv);
+    GLFWwindow* window = window_handler::initialize(resolution, 3, 2);
+
+    // one small triangle per body
+    GLfloat const vertices[] = {-1.0f, -1.0f, 0.0f, 1.0f, 1.0f, 1.0f,
+                                 1.0f, -1.0f, 0.0f, 1.0f, 1.0f, 1.0f,
+                                 0.0f,  1.0f, 0.0f, 1.0f, 1.0f, 1.0f};
+    GLuint vertex_array = 0;
+    GLuint vertex_buffer = 0;
+    glGenVertexArrays(1, &vertex_array);
+    glBindVertexArray(vertex_array);
+    glGenBuffers(1, &vertex_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, GLsizei(6 * sizeof(GLfloat)), nullptr);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, GLsizei(6 * sizeof(GLfloat)), (void*)(3 * sizeof(GLfloat)));
+
+    GLuint program = shader_loader::program({{GL_VERTEX_SHADER, resource_path + "shaders/vao.vert"},
+                                             {GL_FRAGMENT_SHADER, resource_path + "shaders/vao.frag"}});
+    glUseProgram(program);
+    glm::fmat4 view_matrix = glm::inverse(glm::translate(glm::fmat4{}, glm::fvec3{0.0f, 10.0f, 40.0f}));
+    glm::fmat4 projection = utils::calculate_projection_matrix(float(resolution.x) / float(resolution.y));
+    glUniformMatrix4fv(utils::glGetUniformLocation(program, "ViewMatrix"), 1, GL_FALSE, glm::value_ptr(view_matrix));
+    glUniformMatrix4fv(utils::glGetUniformLocation(program, "ProjectionMatrix"), 1, GL_FALSE, glm::value_ptr(projection));
+    GLint model_location = utils::glGetUniformLocation(program, "ModelMatrix");
+    glViewport(0, 0, GLsizei(resolution.x), GLsizei(resolution.y));
+    glEnable(GL_DEPTH_TEST);
+    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+
+    std::cout << std::setw(8) << "bodies" << std::setw(14) << "serial ms" << std::setw(14) << "pipelined ms"
+              << std::setw(10) << "speedup" << std::setw(12) << "wait ms" << std::endl;
+    for (std::size_t bodies : {1024u, 4096u, 16384u}) {
+        test_scene scene = make_scene(bodies);
+        frame_packet packets[2]{};
+        FramePipeline pipeline{[&scene, &packets](std::size_t slot) { prepare(scene, packets[slot]); }};
+        std::size_t pending = 0;
+        pipeline.kick(pending);
+
+        // preparing and submitting in turn on one thread as reference
+        double serial = 0.0;
+        double serial_wait = 0.0;
+        pipeline.setThreaded(false);
+        measure(pipeline, pending, packets, model_location, serial, serial_wait);
+        double pipelined = 0.0;
+        double wait = 0.0;
+        pipeline.setThreaded(true);
+        measure(pipeline, pending, packets, model_location, pipelined, wait);
+
+        std::cout << std::setw(8) << bodies << std::fixed << std::setprecision(3) << std::setw(14) << serial
+                  << std::setw(14) << pipelined << std::setprecision(2) << std::setw(10) << serial / pipelined
+                  << std::setprecision(3) << std::setw(12) << wait << std::endl;
+    }
+
+    glDeleteProgram(program);
+    glDeleteBuffers(1, &vertex_buffer);
+    glDeleteVertexArrays(1, &vertex_array);
+    window_handler::close_and_quit(window, EXIT_SUCCESS);
+}
@@ -0,0 +1,96 @@
+#include "transform_batch.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+typedef void (*multiply_kernel)(glm::fmat4 const*, glm::fmat4 const*, glm::fmat4*, std::size_t);
+typedef void (*normal_kernel)(glm::fmat4 const&, glm::fmat4 const*, glm::fmat4*, std::size_t);
+
+// affine transforms like the scene graph builds them
+static std::vector<glm::fmat4> make_transforms(std::size_t count, unsigned seed) {
+    std::mt19937 generator{seed};
+    std::uniform_real_distribution<float> position{-10.0f, 10.0f};
+    std::uniform_real_distribution<float> angle{0.0f, 6.28318531f};
+    std::uniform_real_distribution<float> scale{0.1f, 2.0f};
+
+    std::vector<glm::fmat4> transforms(count);
+    for (glm::fmat4& transform : transforms) {
+        transform = glm::translate(glm::fmat4{}, glm::fvec3{position(generator), position(generator), position(generator)});
+        transform = glm::rotate(transform, angle(generator), glm::normalize(glm::fvec3{1.0f, position(generator), 0.5f}));
+        transform = glm::scale(transform, glm::fvec3{scale(generator), scale(generator), scale(generator)});
+    }
+    return transforms;
+}
+
+static float max_difference(std::vector<glm::fmat4> const& a, std::vector<glm::fmat4> const& b) {
+    float difference = 0.0f;
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        for (int column = 0; column < 4; ++column) {
+            for (int row = 0; row < 4; ++row) {
+                float scale = std::max(1.0f, std::abs(a[i][column][row]));
+                difference = std::max(difference, std::abs(a[i][column][row] - b[i][column][row]) / scale);
+            }
+        }
+    }
+    return difference;
+}
+
+// nanoseconds per matrix, repeated for at least half a second
+template<typename Kernel>
+static double measure(Kernel kernel, std::size_t count) {
+    unsigned runs = 0;
+    auto start = std::chrono::steady_clock::now();
+    double seconds = 0.0;
+    while (seconds < 0.5 || runs < 3) {
+        kernel();
+        ++runs;
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    return seconds * 1e9 / (double(runs) * double(count));
+}
+
+int main(int argc, char* argv[]) {
+    // small enough to stay in cache, like a scene graph
+    std::size_t count = argc > 1 ? std::size_t(std::atol(argv[1])) : 4096;
+
+    std::vector<glm::fmat4> parents = make_transforms(count, 1);
+    std::vector<glm::fmat4> locals = make_transforms(count, 2);
+    std::vector<glm::fmat4> reference(count);
+    std::vector<glm::fmat4> results(count);
+    glm::fmat4 view = glm::inverse(glm::lookAt(glm::fvec3{0.0f, 5.0f, 20.0f}, glm::fvec3{0.0f}, glm::fvec3{0.0f, 1.0f, 0.0f}));
+
+    std::cout << count << " matrices, " << transform_batch::instruction_set() << std::endl;
+    std::cout << std::setw(18) << "kernel" << std::setw(14) << "reference ns" << std::setw(14) << "batch ns"
+              << std::setw(10) << "speedup" << std::setw(14) << "difference" << std::endl;
+
+    multiply_kernel multiplies[] = {transform_batch::multiply_reference, transform_batch::multiply};
+    double multiply_times[2];
+    for (int i = 0; i < 2; ++i) {
+        multiply_kernel kernel = multiplies[i];
+        std::vector<glm::fmat4>& output = i == 0 ? reference : results;
+        multiply_times[i] = measure([&] { kernel(parents.data(), locals.data(), output.data(), count); }, count);
+    }
+    std::cout << std::setw(18) << "multiply" << std::fixed << std::setprecision(2)
+              << std::setw(14) << multiply_times[0] << std::setw(14) << multiply_times[1]
+              << std::setw(10) << multiply_times[0] / multiply_times[1]
+              << std::setw(14) << std::scientific << max_difference(reference, results) << std::endl;
+
+    normal_kernel normals[] = {transform_batch::normal_matrices_reference, transform_batch::normal_matrices};
+    double normal_times[2];
+    for (int i = 0; i < 2; ++i) {
+        normal_kernel kernel = normals[i];
+        std::vector<glm::fmat4>& output = i == 0 ? reference : results;
+        normal_times[i] = measure([&] { kernel(view, parents.data(), output.data(), count); }, count);
+    }
+    std::cout << std::setw(18) << "normal matrices" << std::fixed << std::setprecision(2)
+              << std::setw(14) << normal_times[0] << std::setw(14) << normal_times[1]
+              << std::setw(10) << normal_times[0] / normal_times[1]
+              << std::setw(14) << std::scientific << max_difference(reference, results) << std::endl;
+}
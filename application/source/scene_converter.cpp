@@ -0,0 +1,22 @@
+#include "scene_file.hpp"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+
+// converts a json scene to the binary form, which the loader reads without parsing
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        std::cerr << "usage: " << argv[0] << " <scene.json> <scene.bin>" << std::endl;
+        return EXIT_FAILURE;
+    }
+    try {
+        scene_description scene = scene_file::load(argv[1]);
+        scene_file::save_binary(scene, argv[2]);
+        std::cout << "wrote " << scene.bodies.size() << " bodies to " << argv[2] << std::endl;
+    }
+    catch (std::exception& error) {
+        std::cerr << error.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,93 @@
+#include "node_pool.hpp"
+#include "node.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+// counts destroyed nodes, so leaked subtrees show up
+static int destroyed = 0;
+
+class CountedNode : public Node {
+public:
+    CountedNode() = default;
+    CountedNode(std::string const& name, std::shared_ptr<Node> const& parent)
+     :Node{name, parent, glm::fmat4{1.0f}}
+    {}
+    ~CountedNode() {
+        ++destroyed;
+    }
+};
+
+static int failures = 0;
+
+static void check(bool condition, std::string const& message) {
+    if (!condition) {
+        std::cerr << "FAILED: " << message << std::endl;
+        ++failures;
+    }
+}
+
+// root -> holders -> moons, linked like the solar system builds them, spread over several chunks
+static std::shared_ptr<CountedNode> make_subtree(NodePool<CountedNode>& pool) {
+    std::shared_ptr<CountedNode> root = pool.create();
+    for (int holder_index = 0; holder_index < 3; ++holder_index) {
+        std::shared_ptr<CountedNode> holder = pool.create("holder " + std::to_string(holder_index), root);
+        root->addChild(holder);
+        for (int moon_index = 0; moon_index < 2; ++moon_index) {
+            holder->addChild(pool.create("moon " + std::to_string(moon_index), holder));
+        }
+    }
+    return root;
+}
+
+int main() {
+    // two linked nodes in one chunk
+    destroyed = 0;
+    {
+        NodePool<CountedNode> pool{};
+        std::shared_ptr<CountedNode> root = pool.create();
+        std::shared_ptr<CountedNode> child = pool.create("child", root);
+        root->addChild(child);
+    }
+    check(destroyed == 2, "linked pair destroyed with the pool, " + std::to_string(destroyed) + " of 2");
+
+    // subtree outliving the pool is destroyed with its last pointer
+    destroyed = 0;
+    {
+        std::shared_ptr<CountedNode> root{};
+        {
+            NodePool<CountedNode> pool{2};
+            root = make_subtree(pool);
+            check(pool.size() == 10, "pool holds the subtree");
+        }
+        check(destroyed == 0, "subtree referenced from outside survives the pool");
+        check(root->getChildren().size() == 3 && root->getChildren().front()->getChildren().size() == 2,
+              "subtree intact after the pool is gone");
+    }
+    check(destroyed == 10, "subtree destroyed with its root, " + std::to_string(destroyed) + " of 10");
+
+    // the pool owns its nodes until clear destroys them all at once
+    destroyed = 0;
+    {
+        NodePool<CountedNode> pool{4};
+        pool.reserve(10);
+        std::shared_ptr<CountedNode> root = make_subtree(pool);
+        check(pool.get(1) != nullptr && pool.get(1)->getName() == "holder 0", "handle in creation order");
+        root.reset();
+        check(destroyed == 0, "subtree kept by the pool, " + std::to_string(destroyed) + " destroyed");
+        pool.clear();
+        check(destroyed == 10, "subtree destroyed by clear, " + std::to_string(destroyed) + " of 10");
+        check(pool.size() == 0 && pool.get(1) == nullptr, "cleared pool is empty");
+        // a cleared pool starts a new arena
+        root = make_subtree(pool);
+        check(pool.size() == 10 && root->getChildren().size() == 3, "pool reused after clear");
+    }
+    check(destroyed == 20, "reused pool destroyed with its root, " + std::to_string(destroyed) + " of 20");
+
+    if (failures > 0) {
+        return EXIT_FAILURE;
+    }
+    std::cout << "node pool: all checks passed" << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,15 @@
+#ifndef ALLOCATION_COUNTER_HPP
+#define ALLOCATION_COUNTER_HPP
+
+#include <cstddef>
+
+// counts calls of the global operator new, only in debug builds
+// used to check that the frame loop does not allocate, allocations of drivers through malloc are not seen
+namespace allocation_counter {
+// whether allocations are counted in this build
+bool enabled();
+// allocations since program start, 0 if not enabled
+std::size_t count();
+}
+
+#endif
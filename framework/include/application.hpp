@@ -2,6 +2,9 @@
 #define APPLICATION_HPP
 
 #include "structs.hpp"
+#include "file_watcher.hpp"
+#include "shader_loader.hpp"
+#include "frame_pacer.hpp"
 
 #include <glm/gtc/type_precision.hpp>
 
@@ -27,6 +30,10 @@ public:
     void mouse_callback(GLFWwindow* window, double pos_x, double pos_y);
     // recompile shaders form source files
     void reloadShaders(bool throwing);
+    // start recompiling all shaders without blocking
+    void requestShaderReload();
+    // recompile programs whose sources changed, swap in finished ones
+    void pollShaderChanges();
 
     // function which are implemented in derived classes
     // update uniform locations and values
@@ -37,16 +44,30 @@ public:
     inline virtual void mouseCallback(double pos_x, double pos_y) {};
     // update framebuffer textures
     inline virtual void resizeCallback(unsigned width, unsigned height) {};
+    // advance state once per frame before drawing
+    inline virtual void update() {};
     // draw all objects
     virtual void render() const = 0;
 
 protected:
     void updateUniformLocations();
+    // compile a single program and update its uniform locations
+    void loadShaderProgram(std::string const& name, bool throwing);
+    // start compiling program, replacing an unfinished compilation
+    void beginShaderCompile(std::string const& name);
 
     std::string m_resource_path;
+    // directory holding linked program binaries
+    std::string m_shader_cache_path;
 
     // container for the shader programs
     std::map<std::string, shader_program> m_shaders{};
+    // compilations that are not swapped in yet, mapped to program name
+    std::map<std::string, shader_loader::pending_program> m_pending_programs{};
+    // reports edited shader sources
+    FileWatcher m_shader_watcher;
+    // waiting between frames, cycled with V
+    FramePacer m_frame_pacer;
 
     // resolution when
     static const glm::uvec2 initial_resolution;
@@ -56,6 +77,7 @@ protected:
 
 #include "utils.hpp"
 #include "window_handler.hpp"
+#include "allocation_counter.hpp"
 
 template<typename T>
 void Application::run(int argc, char* argv[], unsigned ver_major, unsigned ver_minor) {  
@@ -76,16 +98,26 @@ void Application::run(int argc, char* argv[], unsigned ver_major, unsigned ver_m
     
     // rendering loop
     while (!glfwWindowShouldClose(window)) {
+        // sleeps here while rendering on demand and nothing changed
+        application->m_frame_pacer.waitForEvents();
+        // a frame should not allocate, counted in debug builds only
+        std::size_t allocations = allocation_counter::count();
         // query input
         glfwPollEvents();
+        // swap in edited shaders once they are compiled
+        application->pollShaderChanges();
+        // per frame work outside of drawing
+        application->update();
         // clear buffer
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         // draw geometry
         application->render();
         // swap draw buffer to front
         glfwSwapBuffers(window);
+        // wait for the next frame of a capped frame rate
+        application->m_frame_pacer.endFrame();
         // display fps
-        window_handler::show_fps(window);
+        window_handler::show_fps(window, allocation_counter::count() - allocations, &application->m_frame_pacer);
     }
 
     delete application;
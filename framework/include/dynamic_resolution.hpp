@@ -0,0 +1,62 @@
+#ifndef DYNAMIC_RESOLUTION_HPP
+#define DYNAMIC_RESOLUTION_HPP
+
+#include <glbinding/gl/types.h>
+// use gl definitions from glbinding
+using namespace gl;
+
+#include <glm/gtc/type_precision.hpp>
+
+#include <chrono>
+#include <cstddef>
+
+// scales the rendered resolution so the gpu time of a frame stays within a budget
+// frames are timed with timer queries, read a few frames later so the cpu never waits for them
+// without timer queries the interval between frames is used instead
+class DynamicResolution {
+public:
+    // scale applies to both axes, the budget is in milliseconds, requires a current context
+    DynamicResolution(float min_scale, float max_scale, double budget);
+    ~DynamicResolution();
+
+    DynamicResolution(DynamicResolution const&) = delete;
+    DynamicResolution& operator=(DynamicResolution const&) = delete;
+
+    // bracket all gpu work of a frame, not nestable with other time queries
+    void beginFrame();
+    void endFrame();
+
+    // current scale, the maximum while disabled
+    float getScale() const;
+    // part of a full size target the frame is rendered into, at least one pixel
+    glm::uvec2 getRenderSize(glm::uvec2 const& full_size) const;
+
+    bool getEnabled() const;
+    void setEnabled(bool enabled);
+    double getBudget() const;
+    void setBudget(double budget);
+    // last measured frame time in milliseconds
+    double getFrameTime() const;
+    // whether the gpu time is measured, otherwise the frame interval
+    bool getTimerSupport() const;
+
+private:
+    // move the scale towards the one matching the budget
+    void update(double milliseconds);
+
+    // frames in flight before a query is read
+    static const std::size_t query_count = 4;
+
+    float min_scale_;
+    float max_scale_;
+    float scale_;
+    double budget_;
+    double frame_time_;
+    bool enabled_;
+    bool timer_;
+    GLuint queries_[query_count];
+    std::size_t frame_;
+    std::chrono::steady_clock::time_point last_frame_;
+};
+
+#endif
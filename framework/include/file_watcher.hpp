@@ -0,0 +1,39 @@
+#ifndef FILE_WATCHER_HPP
+#define FILE_WATCHER_HPP
+
+#include <chrono>
+#include <ctime>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+// reports modified files without blocking
+// uses inotify on Linux, elsewhere modification times are polled
+class FileWatcher {
+public:
+    FileWatcher();
+    ~FileWatcher();
+
+    FileWatcher(FileWatcher const&) = delete;
+    FileWatcher& operator=(FileWatcher const&) = delete;
+
+    // start watching file, no effect if already watched
+    void watch(std::string const& path);
+    // files modified since the last call, each reported once
+    std::vector<std::string> poll();
+
+private:
+    std::set<std::string> files_;
+#ifdef __linux__
+    // directories are watched, editors often replace files instead of writing them
+    int inotify_fd_;
+    // watch descriptor -> directory
+    std::map<int, std::string> directories_;
+#else
+    std::map<std::string, std::time_t> modification_times_;
+    std::chrono::steady_clock::time_point last_poll_;
+#endif
+};
+
+#endif
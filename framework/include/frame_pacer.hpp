@@ -0,0 +1,66 @@
+#ifndef FRAME_PACER_HPP
+#define FRAME_PACER_HPP
+
+#include <chrono>
+#include <cstddef>
+
+// decides how the main loop waits between frames and measures how evenly frames are spaced
+class FramePacer {
+public:
+    enum mode {
+        // swap waits for the display refresh
+        VSYNC = 0,
+        // fixed frame rate, slept and then spun to the deadline, no display sync
+        CAPPED,
+        // vsync that tears instead of halving the frame rate when a frame is late, vsync if not supported
+        ADAPTIVE,
+        // vsync, but the loop sleeps until input arrives or a redraw is requested
+        ON_DEMAND,
+        // as fast as possible
+        UNCAPPED,
+        MODE_COUNT
+    };
+
+    // sets the swap interval of the current context
+    FramePacer(mode pacing = VSYNC, double frame_rate_cap = 60.0);
+
+    mode getMode() const;
+    void setMode(mode pacing);
+    static char const* getModeName(mode pacing);
+    double getFrameRateCap() const;
+    void setFrameRateCap(double frame_rate);
+
+    // before polling input, blocks while rendering on demand and nothing requested a redraw
+    void waitForEvents();
+    // the next frame has to be drawn, e.g. after input or while something moves
+    void requestRedraw();
+    // after swapping, waits for the deadline of a capped frame rate and records the frame time
+    void endFrame();
+
+    // frame times in milliseconds over the last completed second
+    double getMeanFrameTime() const;
+    double getFrameTimeDeviation() const;
+
+private:
+    typedef std::chrono::steady_clock clock;
+
+    void applySwapInterval() const;
+    // sleep most of the way, spin the rest, sleeping alone overshoots by up to a scheduler tick
+    void waitUntil(clock::time_point deadline) const;
+
+    mode mode_;
+    double frame_rate_cap_;
+    bool redraw_requested_;
+    clock::time_point deadline_;
+    clock::time_point last_frame_;
+
+    // running mean and squared deviation of the current second
+    std::size_t frames_;
+    double mean_;
+    double squared_deviation_;
+    clock::time_point window_start_;
+    double last_mean_;
+    double last_deviation_;
+};
+
+#endif
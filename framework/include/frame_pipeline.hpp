@@ -0,0 +1,45 @@
+#ifndef FRAME_PIPELINE_HPP
+#define FRAME_PIPELINE_HPP
+
+#include "job_system.hpp"
+
+#include <cstddef>
+#include <functional>
+
+// prepares the next frame as a job while the thread owning the gl context submits the current one
+// frames are prepared into slots, usually two packets used alternately, the prepare function must not call gl
+class FramePipeline {
+public:
+    // fills the slot with everything needed to submit a frame
+    typedef std::function<void(std::size_t)> prepare_function;
+
+    explicit FramePipeline(prepare_function const& prepare, JobSystem& jobs = JobSystem::shared());
+    // waits for a running preparation
+    ~FramePipeline();
+
+    FramePipeline(FramePipeline const&) = delete;
+    FramePipeline& operator=(FramePipeline const&) = delete;
+
+    // waits for the previous preparation, then queues the preparation of the slot
+    // without threading the slot is prepared before returning
+    void kick(std::size_t slot);
+    // blocks until the last kicked slot is prepared, state read by the prepare function may be changed afterwards
+    // exceptions of the prepare function are rethrown here
+    void wait();
+
+    // preparation as job or on the calling thread
+    bool getThreaded() const;
+    void setThreaded(bool threaded);
+    // milliseconds the last wait blocked because preparing took longer than submitting
+    double getWaitTime() const;
+
+private:
+    prepare_function prepare_;
+    JobSystem& jobs_;
+    // the handoff, reaches zero once the slot contents are published
+    JobCounter preparing_;
+    bool threaded_;
+    double wait_time_;
+};
+
+#endif
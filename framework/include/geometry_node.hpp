@@ -2,6 +2,7 @@
 #define GEOMETRY_NODE_HPP
 
 #include "node.hpp"
+#include "kepler.hpp"
 #include <memory>
 #include <string>
 
@@ -22,7 +23,7 @@ public:
                  int index);
 
     // get attribute methods
-    model getGeometry() const;
+    model const &getGeometry() const;
     float getSize() const;
     float getSpeed() const;
     float getDistance() const;
@@ -33,7 +34,7 @@ public:
     // set attribute methods
     void setGeometry(model const &geometry);
 
-    std::string getTexture() const;
+    std::string const &getTexture() const;
     texture_object getTextureObject() const;
     int getIndex() const;
 
@@ -46,6 +47,10 @@ public:
     glm::fvec3 getColor() const;
     void setTextureObject(texture_object texture_object);
 
+    // orbit around the parent body
+    orbital_elements const& getOrbit() const;
+    void setOrbit(orbital_elements const& orbit);
+
 private:
     // attributes
     model geometry_;
@@ -57,6 +62,7 @@ private:
     std::string texture_;
     texture_object texture_object_;
     int index_;
+    orbital_elements orbit_;
 };
 
 #endif
@@ -0,0 +1,279 @@
+#ifndef JOB_SYSTEM_HPP
+#define JOB_SYSTEM_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+struct job;
+
+// unfinished jobs of a group, waited on or used as dependency of later jobs
+// must outlive the jobs counted by it
+class JobCounter {
+public:
+    JobCounter();
+
+    JobCounter(JobCounter const&) = delete;
+    JobCounter& operator=(JobCounter const&) = delete;
+
+    // no counted job is queued or running
+    bool done() const;
+
+private:
+    friend class JobSystem;
+
+    std::atomic<std::size_t> pending_;
+    // jobs started once the count reaches zero, linked by their next job, and the first exception of a counted job
+    std::mutex mutex_;
+    job* dependents_;
+    std::exception_ptr error_;
+};
+
+// callable stored inside its job, so queuing it allocates nothing
+// captures must fit the buffer, larger state is captured by reference
+class JobFunction {
+public:
+    static const std::size_t capacity = 64;
+
+    JobFunction();
+    ~JobFunction();
+
+    JobFunction(JobFunction const&) = delete;
+    JobFunction& operator=(JobFunction const&) = delete;
+
+    // stores a copy of the function instead of the current one
+    template<typename Function>
+    void assign(Function const& function);
+    // destroys the stored function with its captures
+    void reset();
+    void operator()();
+
+private:
+    template<typename Function>
+    static void invoke(void* function);
+    template<typename Function>
+    static void destroy(void* function);
+
+    std::aligned_storage<capacity>::type storage_;
+    void (*invoke_)(void*);
+    void (*destroy_)(void*);
+};
+
+// queued function, reused through the pool of the job system
+// next links it into the free jobs, the shared queue or the dependents of a counter
+struct job {
+    JobFunction function;
+    char const* name;
+    JobCounter* counter;
+    job* next;
+};
+
+// fixed size deque of one worker, chase-lev algorithm without locks
+// the owner pushes and pops at the bottom, other workers steal from the top
+class WorkStealingDeque {
+public:
+    // power of two
+    static const std::size_t capacity = 4096;
+
+    WorkStealingDeque();
+
+    WorkStealingDeque(WorkStealingDeque const&) = delete;
+    WorkStealingDeque& operator=(WorkStealingDeque const&) = delete;
+
+    // owner only, false if full
+    bool push(job* task);
+    // owner only, most recently pushed job, nullptr if empty
+    job* pop();
+    // any thread, oldest job, nullptr if empty or lost against another thief
+    job* steal();
+
+private:
+    std::atomic<std::int64_t> top_;
+    std::atomic<std::int64_t> bottom_;
+    std::atomic<job*> jobs_[capacity];
+};
+
+// workers each running jobs from their own deque and stealing from the others when it is empty
+// jobs started by workers go to their deque, jobs of other threads to a shared queue
+class JobSystem {
+public:
+    // 0 workers for one less than hardware threads, at least one
+    explicit JobSystem(unsigned workers = 0);
+    // queued jobs are finished first
+    ~JobSystem();
+
+    JobSystem(JobSystem const&) = delete;
+    JobSystem& operator=(JobSystem const&) = delete;
+
+    // scheduler used by the framework, created on first use
+    static JobSystem& shared();
+
+    // queue a copy of the function, the counter is incremented until it returned
+    // name shows up in the trace and must stay valid, usually a literal
+    template<typename Function>
+    void run(char const* name, Function const& function, JobCounter* counter = nullptr);
+    // queued once the dependency reached zero
+    template<typename Function>
+    void run(char const* name, Function const& function, JobCounter* counter, JobCounter& dependency);
+    // until the counter is zero, workers run other jobs meanwhile, other threads only wait
+    // the first exception of a counted job is rethrown
+    void wait(JobCounter& counter);
+
+    // function(begin, end) on ranges of at least grain elements, returns once all are done
+    // the calling thread runs the last range itself
+    template<typename Function>
+    void parallelFor(char const* name, std::size_t count, std::size_t grain, Function const& function);
+
+    unsigned getWorkerCount() const;
+
+    // record start and duration of every job
+    void setTracing(bool tracing);
+    bool getTracing() const;
+    // jobs recorded since tracing was enabled in the chrome trace event format, for chrome://tracing
+    void writeTrace(std::string const& path) const;
+
+private:
+    typedef std::chrono::steady_clock clock;
+    struct trace_event {
+        char const* name;
+        std::size_t thread;
+        clock::time_point start;
+        clock::time_point end;
+    };
+
+    void work(std::size_t worker);
+    // index of the calling worker, the worker count for other threads
+    std::size_t workerIndex() const;
+    // job from the pool holding a copy of the function, counted by the counter
+    template<typename Function>
+    job* prepare(char const* name, Function const& function, JobCounter* counter);
+    job* allocate();
+    void release(job* task);
+    // adds count jobs to the pool
+    void addJobs(std::size_t count);
+    void schedule(job* task);
+    // once the dependency reached zero
+    void schedule(job* task, JobCounter& dependency);
+    // own deque, then the shared queue, then the other deques
+    job* find(std::size_t worker);
+    void execute(job* task, std::size_t worker);
+    void finish(JobCounter& counter);
+
+    std::vector<std::unique_ptr<WorkStealingDeque>> deques_;
+    // oldest first, linked by their next job
+    job* shared_front_;
+    job* shared_back_;
+    std::mutex shared_mutex_;
+
+    // jobs are reused, the pool only grows while more are pending at once than ever before
+    std::vector<std::unique_ptr<job[]>> job_blocks_;
+    job* free_jobs_;
+    std::mutex pool_mutex_;
+
+    // jobs in any queue, idle workers sleep while it is zero
+    std::atomic<std::size_t> queued_;
+    bool stopping_;
+    std::mutex sleep_mutex_;
+    std::condition_variable sleep_signal_;
+
+    std::atomic<bool> tracing_;
+    clock::time_point trace_start_;
+    std::vector<trace_event> trace_;
+    mutable std::mutex trace_mutex_;
+
+    std::vector<std::thread> workers_;
+};
+
+template<typename Function>
+void JobFunction::assign(Function const& function) {
+    static_assert(sizeof(Function) <= capacity, "job system: captures do not fit into a job");
+    static_assert(std::alignment_of<Function>::value <= std::alignment_of<decltype(storage_)>::value,
+                  "job system: captures are aligned stricter than a job");
+    reset();
+    new (&storage_) Function(function);
+    invoke_ = &JobFunction::invoke<Function>;
+    destroy_ = &JobFunction::destroy<Function>;
+}
+
+template<typename Function>
+void JobFunction::invoke(void* function) {
+    (*static_cast<Function*>(function))();
+}
+
+template<typename Function>
+void JobFunction::destroy(void* function) {
+    static_cast<Function*>(function)->~Function();
+}
+
+template<typename Function>
+void JobSystem::run(char const* name, Function const& function, JobCounter* counter) {
+    schedule(prepare(name, function, counter));
+}
+
+template<typename Function>
+void JobSystem::run(char const* name, Function const& function, JobCounter* counter, JobCounter& dependency) {
+    schedule(prepare(name, function, counter), dependency);
+}
+
+template<typename Function>
+job* JobSystem::prepare(char const* name, Function const& function, JobCounter* counter) {
+    job* task = allocate();
+    try {
+        task->function.assign(function);
+    }
+    catch (...) {
+        release(task);
+        throw;
+    }
+    task->name = name;
+    task->counter = counter;
+    if (counter != nullptr) {
+        counter->pending_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return task;
+}
+
+template<typename Function>
+void JobSystem::parallelFor(char const* name, std::size_t count, std::size_t grain, Function const& function) {
+    // a few ranges per thread, so stealing evens out ranges of different cost
+    std::size_t ranges = std::min((count + std::max(grain, std::size_t(1)) - 1) / std::max(grain, std::size_t(1)),
+                                  std::size_t(getWorkerCount() + 1) * 4);
+    if (ranges <= 1) {
+        if (count > 0) {
+            function(std::size_t(0), count);
+        }
+        return;
+    }
+    std::size_t size = (count + ranges - 1) / ranges;
+    JobCounter counter{};
+    std::size_t begin = 0;
+    for (; begin + size < count; begin += size) {
+        std::size_t end = begin + size;
+        run(name, [&function, begin, end]() { function(begin, end); }, &counter);
+    }
+    // the queued ranges still reference function and counter, so they are waited for in any case
+    std::exception_ptr error{};
+    try {
+        function(begin, count);
+    }
+    catch (...) {
+        error = std::current_exception();
+    }
+    wait(counter);
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef KEPLER_HPP
+#define KEPLER_HPP
+
+#include <glm/gtc/type_precision.hpp>
+
+#include <cstddef>
+#include <vector>
+
+// classical orbital elements, angles in radians, origin in the focus
+struct orbital_elements {
+    float semi_major_axis = 0.0f;
+    float eccentricity = 0.0f;
+    float inclination = 0.0f;
+    // longitude of the ascending node, measured around the y axis
+    float ascending_node = 0.0f;
+    float periapsis_argument = 0.0f;
+    // mean anomaly at time zero
+    float mean_anomaly = 0.0f;
+    // radians per second
+    float mean_motion = 0.0f;
+};
+
+namespace kepler {
+// elements of many bodies as structure of arrays, for vectorized propagation
+struct orbit_batch {
+    std::vector<float> mean_anomaly{};
+    std::vector<float> mean_motion{};
+    std::vector<float> eccentricity{};
+    std::vector<float> semi_major_axis{};
+    std::vector<float> semi_minor_axis{};
+    // periapsis direction and its normal in the orbital plane
+    std::vector<float> p_x{}, p_y{}, p_z{};
+    std::vector<float> q_x{}, q_y{}, q_z{};
+    // results of propagate, position relative to the focus
+    std::vector<float> x{}, y{}, z{};
+};
+
+// append body, returns its index in the batch
+std::size_t add(orbit_batch& batch, orbital_elements const& elements);
+
+// eccentric anomaly E solving E - e sin E = M, scalar reference with convergence check
+float solve(float mean_anomaly, float eccentricity);
+// solve count equations with fixed newton iterations on all lanes
+void solve(float const* mean_anomaly, float const* eccentricity, float* eccentric_anomaly, std::size_t count);
+// same equations, one body at a time with the reference solver
+void solve_reference(float const* mean_anomaly, float const* eccentricity, float* eccentric_anomaly, std::size_t count);
+
+// update positions of all bodies for time in seconds
+void propagate(orbit_batch& batch, float time);
+// position of single body, scalar reference
+glm::fvec3 position(orbital_elements const& elements, float time);
+
+// instruction set used by the batch solver
+char const* instruction_set();
+}
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef MESH_REGISTRY_HPP
+#define MESH_REGISTRY_HPP
+
+#include "model.hpp"
+
+#include <glbinding/gl/types.h>
+// use gl definitions from glbinding
+using namespace gl;
+
+#include <cstddef>
+#include <vector>
+
+// memory layout of the commands read by glMultiDrawElementsIndirect
+struct draw_elements_indirect_command {
+    GLuint count;
+    GLuint instance_count;
+    GLuint first_index;
+    GLint base_vertex;
+    // selects the per-draw data, passed to shaders as draw index
+    GLuint base_instance;
+};
+
+// part of the shared buffers holding one mesh
+struct mesh_range {
+    GLuint first_index;
+    GLuint index_count;
+    GLint base_vertex;
+    GLuint vertex_count;
+};
+
+// all meshes suballocated in one vertex and one index buffer behind a single vertex array
+// vertices are position, normal and texture coordinate at locations 0 to 2
+// location 3 is the draw index, the base instance of the command with multi draw indirect
+// without multi draw indirect every command is drawn on its own and the base instance is set as uniform
+class MeshRegistry {
+public:
+    MeshRegistry();
+    // free buffers and vertex array
+    ~MeshRegistry();
+
+    MeshRegistry(MeshRegistry const&) = delete;
+    MeshRegistry& operator=(MeshRegistry const&) = delete;
+
+    // copy triangle mesh into the shared buffers, attributes missing in the model are zero
+    // returns the mesh handle, buffers are reallocated when bound next
+    std::size_t add(model const& mesh);
+    mesh_range const& getRange(std::size_t mesh) const;
+    std::size_t getMeshCount() const;
+    // single instance of a mesh
+    draw_elements_indirect_command makeCommand(std::size_t mesh, GLuint base_instance = 0) const;
+
+    // upload meshes added since the last call
+    void upload();
+    // upload and bind the shared vertex array
+    void bind();
+    GLuint getVertexArray() const;
+    // one mesh, without draw index
+    void draw(std::size_t mesh) const;
+    // commands of the frame, drawn in ranges by drawCommands
+    void setCommands(std::vector<draw_elements_indirect_command> const& commands);
+    // one multi draw indirect call for all commands in the range if supported
+    // otherwise one draw per command, writing its base instance to the draw offset uniform
+    void drawCommands(std::size_t first, std::size_t count, GLint draw_offset_location) const;
+
+    // whether commands are submitted with glMultiDrawElementsIndirect
+    bool getIndirectSupport() const;
+    // gl draw calls issued since the last setCommands
+    std::size_t getDrawCallCount() const;
+
+private:
+    std::vector<GLfloat> vertices_;
+    std::vector<GLuint> indices_;
+    std::vector<mesh_range> ranges_;
+    // meshes in the buffers, ranges_ beyond this are not uploaded yet
+    std::size_t uploaded_meshes_;
+
+    GLuint vertex_array_;
+    GLuint vertex_buffer_;
+    GLuint element_buffer_;
+    // 0, 1, 2, ... read once per instance, offset by the base instance
+    GLuint draw_index_buffer_;
+    std::size_t draw_index_count_;
+    GLuint indirect_buffer_;
+
+    // copy of the commands for drawing them one by one
+    std::vector<draw_elements_indirect_command> commands_;
+    mutable std::size_t draw_calls_;
+    bool indirect_;
+};
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef NBODY_HPP
+#define NBODY_HPP
+
+#include <glm/gtc/type_precision.hpp>
+
+#include <cstddef>
+#include <vector>
+
+// gravitational n-body system, forces approximated with a barnes-hut octree
+// integrated with kick-drift-kick leapfrog, which keeps energy bounded over long runs
+class NBodySimulation {
+public:
+    // opening angle: cells smaller than angle * distance are treated as single mass
+    // softening avoids singular forces in close encounters
+    NBodySimulation(float gravity = 1.0f, float opening_angle = 0.5f, float softening = 0.01f);
+
+    std::size_t addBody(glm::fvec3 const& position, glm::fvec3 const& velocity, float mass);
+    void clear();
+
+    // advance by dt, tree is rebuilt once per step
+    void step(float dt);
+
+    glm::fvec3 getPosition(std::size_t body) const;
+    glm::fvec3 getVelocity(std::size_t body) const;
+    float getMass(std::size_t body) const;
+    std::size_t getBodyCount() const;
+    std::size_t getCellCount() const;
+
+    // ranges the force evaluation is split into at most, each a job of the shared job system
+    // 0 for one per worker and one for the calling thread
+    void setThreadCount(unsigned threads);
+    unsigned getThreadCount() const;
+
+    // kinetic plus potential energy, direct summation O(n^2)
+    double getEnergy() const;
+
+private:
+    struct cell {
+        glm::fvec3 center;
+        float half_size;
+        glm::fvec3 center_of_mass;
+        float mass;
+        int parent;
+        // index of first of 8 consecutive children, -1 for leaves
+        int children;
+        // first body of a leaf, further bodies are linked through next_body_
+        int body;
+    };
+
+    void buildTree();
+    void insert(int body);
+    int childCell(int cell, glm::fvec3 const& position);
+    void subdivide(int cell);
+    void computeForces();
+    void computeForces(std::size_t begin, std::size_t end);
+    glm::fvec3 acceleration(std::size_t body) const;
+
+    float gravity_;
+    float opening_angle_;
+    float softening_;
+    unsigned threads_;
+    // accelerations of the current positions are known
+    bool forces_valid_;
+
+    // one entry per body in each array
+    std::vector<glm::fvec3> positions_;
+    std::vector<glm::fvec3> velocities_;
+    std::vector<glm::fvec3> accelerations_;
+    std::vector<float> masses_;
+    std::vector<int> next_body_;
+
+    std::vector<cell> cells_;
+};
+
+#endif
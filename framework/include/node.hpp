@@ -24,13 +24,14 @@ public:
          glm::fmat4 const &localTansform);
 
     // get attribute methods
-    std::string getName();
-    std::shared_ptr<Node> getParent();
-    std::list<std::shared_ptr<Node>> getChildren();
-    std::string getPath();
-    int getDepth();
-    glm::fmat4 getWorldTransform();
-    glm::fmat4 getLocalTransform();
+    std::string const &getName() const;
+    std::shared_ptr<Node> getParent() const;
+    std::list<std::shared_ptr<Node>> const &getChildren() const;
+    // names from the root down, e.g. /root/earth holder/moon
+    std::string const &getPath() const;
+    int getDepth() const;
+    glm::fmat4 const &getWorldTransform() const;
+    glm::fmat4 const &getLocalTransform() const;
 
     // Distance to the origin
     Node *getOrigin() const;
@@ -43,23 +44,30 @@ public:
     virtual float getDistance() const;
 
     // light set and get
-    bool getIsLight();
+    bool getIsLight() const;
     void setIsLight(bool isLight);
 
     // set attribute methods
     void setParent(std::shared_ptr<Node> const &parent);
     void setWorldTransform(glm::fmat4 const &worldTransform);
+    // store a world transform computed elsewhere, e.g. by transform_batch, local transform is not applied
+    void assignWorldTransform(glm::fmat4 const &worldTransform);
     void setLocalTransform(glm::fmat4 const &localTransform);
 
     // child specific methods
     std::shared_ptr<Node> getChild(std::string const &childName);
     void addChild(std::shared_ptr<Node> const &);
     void removeChild(std::string const &childName);
+    // only this child, siblings of the same name stay
+    void removeChild(std::shared_ptr<Node> const &child);
 
 private:
+    void updatePath();
+
     // attributes
     std::string name_;
-    std::shared_ptr<Node> parent_;
+    // children own their parent only weakly, otherwise no subtree is ever freed
+    std::weak_ptr<Node> parent_;
     Node *origin_;
     std::list<std::shared_ptr<Node>> children_;
     std::string path_;
@@ -0,0 +1,168 @@
+#ifndef NODE_POOL_HPP
+#define NODE_POOL_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// bump allocated memory in large blocks, nothing is freed before the whole arena
+class NodeArena {
+public:
+    explicit NodeArena(std::size_t block_slots)
+     :block_slots_{block_slots}
+     ,reserved_slots_{0}
+     ,used_{0}
+     ,capacity_{0}
+     ,blocks_{}
+    {}
+
+    NodeArena(NodeArena const&) = delete;
+    NodeArena& operator=(NodeArena const&) = delete;
+
+    // a slot is one node with its reference count, the first allocation decides its size
+    void* allocate(std::size_t bytes, std::size_t alignment) {
+        std::size_t offset = aligned(used_, alignment);
+        if (blocks_.empty() || offset + bytes > capacity_) {
+            std::size_t slots = std::max(block_slots_, reserved_slots_);
+            reserved_slots_ = 0;
+            // room for aligning the first slot
+            capacity_ = slots * bytes + alignment;
+            blocks_.emplace_back(new char[capacity_]);
+            used_ = 0;
+            offset = aligned(used_, alignment);
+        }
+        used_ = offset + bytes;
+        return blocks_.back().get() + offset;
+    }
+
+    // the next block holds at least count slots
+    void reserve(std::size_t count) {
+        reserved_slots_ = count;
+        // a partly filled block is closed, its free slots are not reused
+        capacity_ = used_;
+    }
+
+private:
+    std::size_t aligned(std::size_t offset, std::size_t alignment) const {
+        if (blocks_.empty()) {
+            return offset;
+        }
+        std::uintptr_t address = reinterpret_cast<std::uintptr_t>(blocks_.back().get()) + offset;
+        return offset + (alignment - address % alignment) % alignment;
+    }
+
+    std::size_t block_slots_;
+    std::size_t reserved_slots_;
+    std::size_t used_;
+    std::size_t capacity_;
+    std::vector<std::unique_ptr<char[]>> blocks_;
+};
+
+// places shared pointer blocks in an arena, freeing is left to the arena
+// every copy keeps the arena alive, so nodes may outlive their pool
+template<typename T>
+class NodeArenaAllocator {
+public:
+    typedef T value_type;
+
+    explicit NodeArenaAllocator(std::shared_ptr<NodeArena> const& arena)
+     :arena_{arena}
+    {}
+    template<typename U>
+    NodeArenaAllocator(NodeArenaAllocator<U> const& other)
+     :arena_{other.getArena()}
+    {}
+
+    T* allocate(std::size_t count) {
+        return static_cast<T*>(arena_->allocate(sizeof(T) * count, std::alignment_of<T>::value));
+    }
+    void deallocate(T*, std::size_t) {}
+
+    std::shared_ptr<NodeArena> const& getArena() const {
+        return arena_;
+    }
+
+private:
+    std::shared_ptr<NodeArena> arena_;
+};
+
+template<typename T, typename U>
+bool operator==(NodeArenaAllocator<T> const& a, NodeArenaAllocator<U> const& b) {
+    return a.getArena() == b.getArena();
+}
+template<typename T, typename U>
+bool operator!=(NodeArenaAllocator<T> const& a, NodeArenaAllocator<U> const& b) {
+    return !(a == b);
+}
+
+// typed arena for scene graph nodes
+// each node is constructed together with its reference count in the arena, so creating one allocates nothing
+// the pool owns its nodes until clear, then all are released at once and the arena is freed in whole blocks
+template<typename T>
+class NodePool {
+public:
+    // handle of a node, index in creation order
+    typedef std::size_t handle;
+
+    explicit NodePool(std::size_t chunk_size = 256)
+     :chunk_size_{chunk_size > 0 ? chunk_size : 1}
+     ,arena_{}
+     ,nodes_{}
+    {}
+    ~NodePool() {
+        clear();
+    }
+
+    NodePool(NodePool const&) = delete;
+    NodePool& operator=(NodePool const&) = delete;
+
+    // construct a node in the arena, forwarding the constructor arguments
+    template<typename... Args>
+    std::shared_ptr<T> create(Args&&... args) {
+        if (!arena_) {
+            arena_ = std::make_shared<NodeArena>(chunk_size_);
+        }
+        nodes_.push_back(std::allocate_shared<T>(NodeArenaAllocator<T>{arena_}, std::forward<Args>(args)...));
+        return nodes_.back();
+    }
+
+    // make room for count more nodes in a single block, for building large scenes at once
+    void reserve(std::size_t count) {
+        if (!arena_) {
+            arena_ = std::make_shared<NodeArena>(chunk_size_);
+        }
+        arena_->reserve(count);
+        nodes_.reserve(nodes_.size() + count);
+    }
+
+    // nullptr if the handle was not created since the last clear
+    std::shared_ptr<T> get(handle node) const {
+        return node < nodes_.size() ? nodes_[node] : nullptr;
+    }
+
+    // release all nodes, those still referenced elsewhere live on with the arena
+    void clear() {
+        // children come after their parents, so they are only released and die with the parent's child list
+        while (!nodes_.empty()) {
+            nodes_.pop_back();
+        }
+        nodes_.shrink_to_fit();
+        arena_.reset();
+    }
+
+    std::size_t size() const {
+        return nodes_.size();
+    }
+
+private:
+    std::size_t chunk_size_;
+    std::shared_ptr<NodeArena> arena_;
+    std::vector<std::shared_ptr<T>> nodes_;
+};
+
+#endif
@@ -0,0 +1,209 @@
+#ifndef POST_PROCESS_HPP
+#define POST_PROCESS_HPP
+
+#include "structs.hpp"
+#include "render_target_pool.hpp"
+
+#include <glm/gtc/type_precision.hpp>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+class PostProcessChain;
+
+// single node of the post processing chain
+class PostEffect {
+public:
+    PostEffect(std::string const& name, bool enabled);
+    virtual ~PostEffect();
+
+    std::string const& getName() const;
+    bool getEnabled() const;
+    void setEnabled(bool enabled);
+
+    // per-pixel effects without neighbourhood access are merged into one pass
+    virtual bool isFusible() const = 0;
+
+    // fusible effects: symbol enabling the effect in screen_quad.frag
+    virtual std::string getDefine() const;
+    // fusible effects: request uniform locations in the merged program
+    virtual void addUniforms(shader_program& program) const;
+    // fusible effects: upload parameters to the bound merged program
+    virtual void uploadUniforms(shader_program const& program) const;
+
+    // pass effects: register own programs
+    virtual void addPrograms(std::map<std::string, shader_program>& shaders, std::string const& shader_path) const;
+    // pass effects: upload parameters after compilation, resize or parameter change
+    virtual void uploadProgramUniforms(std::map<std::string, shader_program> const& shaders, glm::uvec2 const& size) const;
+    // pass effects: render from input texture into output framebuffer
+    virtual void execute(PostProcessChain const& chain, GLuint input, GLuint output, glm::uvec2 const& size) const;
+
+private:
+    std::string name_;
+    bool enabled_;
+};
+
+// effect compiled into the screen quad shader through a define
+class PixelEffect : public PostEffect {
+public:
+    PixelEffect(std::string const& name, std::string const& define, bool enabled = false);
+
+    bool isFusible() const;
+    std::string getDefine() const;
+
+private:
+    std::string define_;
+};
+
+// separable gaussian, horizontal pass into a pooled target, vertical pass into output
+class GaussianBlurEffect : public PostEffect {
+public:
+    GaussianBlurEffect(std::string const& name, unsigned radius, bool enabled = false);
+
+    bool isFusible() const;
+    void addPrograms(std::map<std::string, shader_program>& shaders, std::string const& shader_path) const;
+    void uploadProgramUniforms(std::map<std::string, shader_program> const& shaders, glm::uvec2 const& size) const;
+    void execute(PostProcessChain const& chain, GLuint input, GLuint output, glm::uvec2 const& size) const;
+
+    unsigned getRadius() const;
+    // clamped to the taps the shader is compiled for
+    void setRadius(unsigned radius);
+    unsigned getMaxRadius() const;
+
+private:
+    unsigned radius_;
+};
+
+// glow around bright pixels, added on top of the input
+// pixels above the threshold are downsampled through a chain of half resolution targets and blurred back up
+// with a tent filter, every level spreads the light twice as far at a quarter of the cost of the one above
+class BloomEffect : public PostEffect {
+public:
+    BloomEffect(std::string const& name, unsigned levels, bool enabled = false);
+
+    bool isFusible() const;
+    void addPrograms(std::map<std::string, shader_program>& shaders, std::string const& shader_path) const;
+    void uploadProgramUniforms(std::map<std::string, shader_program> const& shaders, glm::uvec2 const& size) const;
+    void execute(PostProcessChain const& chain, GLuint input, GLuint output, glm::uvec2 const& size) const;
+
+    // luminance from which pixels start to glow, faded in over the soft knee below
+    float getThreshold() const;
+    void setThreshold(float threshold);
+    float getIntensity() const;
+    void setIntensity(float intensity);
+
+private:
+    unsigned levels_;
+    float threshold_;
+    float intensity_;
+};
+
+// fast approximate anti-aliasing, blends across edges found in the luminance of the input
+// one full screen pass instead of shading and storing several samples per pixel, needs displayable colors
+class FxaaEffect : public PostEffect {
+public:
+    FxaaEffect(std::string const& name, bool enabled = false);
+
+    bool isFusible() const;
+    void addPrograms(std::map<std::string, shader_program>& shaders, std::string const& shader_path) const;
+    void uploadProgramUniforms(std::map<std::string, shader_program> const& shaders, glm::uvec2 const& size) const;
+    void execute(PostProcessChain const& chain, GLuint input, GLuint output, glm::uvec2 const& size) const;
+};
+
+// maps a high dynamic range input to the displayable range
+// average luminance is found by reducing a log luminance texture through its mip chain on the gpu,
+// the exposure follows it over a few frames like an eye adapting
+class ToneMapEffect : public PostEffect {
+public:
+    ToneMapEffect(std::string const& name, bool enabled = false);
+    // frees the luminance textures, requires a current context
+    ~ToneMapEffect();
+
+    bool isFusible() const;
+    void addPrograms(std::map<std::string, shader_program>& shaders, std::string const& shader_path) const;
+    void uploadProgramUniforms(std::map<std::string, shader_program> const& shaders, glm::uvec2 const& size) const;
+    void execute(PostProcessChain const& chain, GLuint input, GLuint output, glm::uvec2 const& size) const;
+
+    // exposure compensation in stops, added to the adapted exposure
+    float getExposure() const;
+    void setExposure(float stops);
+
+private:
+    // luminance texture and adaptation targets, created on first use
+    void createTargets() const;
+
+    float exposure_;
+    // log luminance with full mip chain
+    mutable GLuint luminance_texture_;
+    mutable GLuint luminance_framebuffer_;
+    // adapted average luminance of the last and the current frame, one texel each
+    mutable GLuint adapted_textures_[2];
+    mutable GLuint adapted_framebuffers_[2];
+    mutable unsigned current_;
+    // seconds between executions drive the adaptation
+    mutable double last_time_;
+};
+
+// ordered list of effects, grouped into as few full screen passes as possible
+class PostProcessChain {
+public:
+    // creates the full screen quad, requires a current context
+    PostProcessChain(std::string const& shader_path, GLenum format = GL_RGB8);
+    ~PostProcessChain();
+
+    PostProcessChain(PostProcessChain const&) = delete;
+    PostProcessChain& operator=(PostProcessChain const&) = delete;
+
+    // effects are applied in insertion order
+    void addEffect(std::shared_ptr<PostEffect> const& effect);
+    std::shared_ptr<PostEffect> getEffect(std::string const& name) const;
+
+    // group enabled effects into passes and register their programs
+    // returns programs that were added and still need compiling
+    std::vector<std::string> build(std::map<std::string, shader_program>& shaders);
+    // upload effect parameters, after compilation, resize or parameter change
+    void uploadUniforms(std::map<std::string, shader_program> const& shaders, glm::uvec2 const& size) const;
+    // run all passes, the last one writes into output framebuffer
+    // input_scale is the part of the input texture holding the image, it is stretched over the output
+    void render(std::map<std::string, shader_program> const& shaders, GLuint input, GLuint output, glm::uvec2 const& size,
+                glm::fvec2 const& input_scale = glm::fvec2{1.0f}) const;
+
+    // used by pass effects
+    shader_program const& getProgram(std::string const& name) const;
+    render_target* acquireTarget(glm::uvec2 const& size) const;
+    render_target* acquireTarget(glm::uvec2 const& size, GLenum format) const;
+    void releaseTarget(render_target* target) const;
+    void drawQuad() const;
+
+    // free intermediates no longer matching the output size
+    void trimTargets();
+    // format of the intermediates, a float format keeps high dynamic range between effects
+    GLenum getFormat() const;
+    void setFormat(GLenum format);
+
+    std::size_t getPassCount() const;
+    RenderTargetPool const& getPool() const;
+
+private:
+    struct pass {
+        // merged per-pixel effects, rendered with program
+        std::vector<std::shared_ptr<PostEffect>> fused;
+        // or a single effect with own passes
+        std::shared_ptr<PostEffect> effect;
+        std::string program;
+    };
+
+    std::string shader_path_;
+    GLenum format_;
+    std::vector<std::shared_ptr<PostEffect>> effects_;
+    std::vector<pass> passes_;
+    model_object quad_;
+    // programs of the current frame, only valid during render
+    mutable std::map<std::string, shader_program> const* shaders_;
+    // intermediate targets, reused as soon as the reading pass is done
+    mutable RenderTargetPool pool_;
+};
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef RENDER_QUEUE_HPP
+#define RENDER_QUEUE_HPP
+
+#include <glbinding/gl/types.h>
+// use gl definitions from glbinding
+using namespace gl;
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// remembers bound objects and skips binds that would not change anything
+// state changed by gl calls outside of the cache must be forgotten with invalidate
+class StateCache {
+public:
+    // texture units tracked, binds to higher units are always issued
+    static const GLuint tracked_units = 16;
+
+    StateCache();
+
+    void useProgram(GLuint program);
+    void bindVertexArray(GLuint vertex_array);
+    // activates the unit only if the texture actually changes
+    void bindTexture(GLuint unit, GLenum target, GLuint texture);
+    // bound state is unknown again, the next bind of everything is issued
+    void invalidate();
+
+    // binds passed to gl and binds skipped since the last reset
+    std::size_t getIssuedCount() const;
+    std::size_t getSkippedCount() const;
+    void resetCounters();
+
+private:
+    struct texture_binding {
+        GLenum target;
+        GLuint handle;
+    };
+    // whether a bind to value is needed, counting it either way
+    bool change(GLuint& current, GLuint value);
+
+    GLuint program_;
+    GLuint vertex_array_;
+    GLuint active_unit_;
+    texture_binding textures_[tracked_units];
+    std::size_t issued_;
+    std::size_t skipped_;
+};
+
+// draws recorded during a frame, executed in order of their sort key
+// the key orders by layer, program, vertex array, texture and depth, so binds repeat as rarely as possible
+// depth sorted layers order by depth right after the layer instead, nearest first for early depth rejection
+class RenderQueue {
+public:
+    // issues the draw, with program, vertex array and texture already bound
+    // the argument is the one given when submitting
+    typedef std::function<void(std::size_t)> draw_function;
+
+    RenderQueue();
+
+    // register a kind of draw once, returns its id for submit
+    std::size_t addPass(draw_function const& draw);
+    // order a layer front to back instead of by state, layers up to 15
+    void setDepthSorted(unsigned layer, bool sorted);
+
+    // record a draw, lower layers are drawn first regardless of state
+    // the texture is bound to unit 0, GL_NONE as target for draws without texture
+    // depth is the view space distance, nearer draws first within equal state
+    void submit(unsigned layer, GLuint program, GLuint vertex_array, GLenum texture_target, GLuint texture,
+                float depth, std::size_t pass, std::size_t argument = 0);
+    // sort and issue all recorded draws, then clear
+    void execute(StateCache& state);
+
+    std::size_t getCommandCount() const;
+
+    static std::uint64_t makeKey(unsigned layer, GLuint program, GLuint vertex_array, GLuint texture, float depth,
+                                 bool depth_first = false);
+
+private:
+    struct render_command {
+        std::uint64_t key;
+        GLuint program;
+        GLuint vertex_array;
+        GLenum texture_target;
+        GLuint texture;
+        std::size_t pass;
+        std::size_t argument;
+    };
+
+    std::vector<draw_function> passes_;
+    // bit per layer
+    std::uint32_t depth_sorted_layers_;
+    // capacity is kept between frames
+    std::vector<render_command> commands_;
+};
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef RENDER_TARGET_POOL_HPP
+#define RENDER_TARGET_POOL_HPP
+
+#include "structs.hpp"
+
+#include <glm/gtc/type_precision.hpp>
+
+#include <memory>
+#include <vector>
+
+// color target handed out by the pool
+struct render_target {
+    framebuffer_object framebuffer;
+    glm::uvec2 size;
+    // sized internal formats of the color textures, in attachment order
+    std::vector<GLenum> formats;
+    // format of the depth texture, GL_NONE for none
+    GLenum depth_format;
+    // above 1 the attachments are multisample textures, resolved by blitting into a single sample target
+    GLsizei samples;
+    // acquired by a pass and not released yet
+    bool in_use;
+};
+
+// owns framebuffers and their attachments
+// released targets are reused for later passes of matching size and format
+class RenderTargetPool {
+public:
+    RenderTargetPool();
+    // free all targets
+    ~RenderTargetPool();
+
+    RenderTargetPool(RenderTargetPool const&) = delete;
+    RenderTargetPool& operator=(RenderTargetPool const&) = delete;
+
+    // return a free target or create one, stays valid until clear
+    render_target* acquire(glm::uvec2 const& size, GLenum format, GLenum depth_format = GL_NONE, GLsizei samples = 1);
+    // target with multiple color attachments, all written by one pass
+    render_target* acquire(glm::uvec2 const& size, std::vector<GLenum> const& formats, GLenum depth_format = GL_NONE,
+                           GLsizei samples = 1);
+    // allow reuse by following passes
+    void release(render_target* target);
+    // reallocate attachments, only if size, format or sample count differ
+    // handles stay valid only if nothing changed, returns whether storage was replaced
+    bool resize(render_target* target, glm::uvec2 const& size, GLenum format, GLenum depth_format = GL_NONE,
+                GLsizei samples = 1);
+    bool resize(render_target* target, glm::uvec2 const& size, std::vector<GLenum> const& formats,
+                GLenum depth_format = GL_NONE, GLsizei samples = 1);
+    // free all targets not in use, e.g. intermediates of an old window size
+    void trim();
+    // free all targets
+    void clear();
+
+    std::size_t getTargetCount() const;
+    // bytes of all attachments currently allocated
+    std::size_t getMemoryUsage() const;
+
+    // highest sample count usable for color and depth textures
+    static GLsizei getMaxSamples();
+
+private:
+    std::vector<std::unique_ptr<render_target>> targets_;
+};
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef SCENE_FILE_HPP
+#define SCENE_FILE_HPP
+
+#include <glm/gtc/type_precision.hpp>
+
+#include <string>
+#include <vector>
+
+// one body of a scene, holder and geometry node in the scene graph
+struct body_description {
+    body_description();
+
+    std::string name;
+    // name of the body orbited, empty for bodies around the origin
+    // parents are listed before their children
+    std::string parent;
+    float size;
+    // mean motion and semi-major axis of the orbit
+    float speed;
+    float distance;
+    glm::fvec3 color;
+    // file name in the texture directory
+    std::string texture;
+    // orientation of the orbit, angles in degrees
+    float eccentricity;
+    float inclination;
+    float ascending_node;
+    float periapsis;
+    // bodies emitting light get a point light as holder
+    bool light;
+    float light_intensity;
+    glm::fvec3 light_color;
+};
+
+struct scene_description {
+    std::string name;
+    std::vector<body_description> bodies;
+};
+
+// scenes are authored as json and can be converted to a compact binary form
+// json layout: {"name": "...", "bodies": [{"name": "earth", "parent": "", "size": 0.2, ...}]}
+// keys of a body match the members of body_description, colors are arrays of three numbers
+// and lights are objects {"intensity": 1.0, "color": [255, 255, 150]}
+namespace scene_file {
+// read a json or binary scene, the format is detected from the content
+// throws std::logic_error for malformed files or unknown parents
+scene_description load(std::string const& path);
+scene_description parse_json(std::string const& text);
+
+// native byte order, only meant to be read on the same platform
+void save_binary(scene_description const& scene, std::string const& path);
+}
+
+#endif
@@ -3,6 +3,8 @@
 
 #include <iostream>
 #include <memory>
+#include <string>
+#include <unordered_map>
 #include "node.hpp"
 #include "geometry_node.hpp"
 #include "point_light_node.hpp"
@@ -15,10 +17,18 @@ class SceneGraph {
   SceneGraph(std::string const& name, std::shared_ptr<Node> const& rootNode);
 
   // get attribute methods
-  std::string getName()const;
+  std::string const& getName()const;
   std::shared_ptr<Node> getRoot()const;
-  std::list<std::shared_ptr<GeometryNode>> getPlanets()const;
-  std::list<std::shared_ptr<PointLightNode>> getLightNodes()const;
+  std::list<std::shared_ptr<GeometryNode>> const& getPlanets()const;
+  std::list<std::shared_ptr<PointLightNode>> const& getLightNodes()const;
+
+  // attach node below parent and index its subtree by path, throws if a path is taken
+  // a node already attached elsewhere is moved with its subtree
+  void addNode(std::shared_ptr<Node> const& parent, std::shared_ptr<Node> const& node);
+  // detach the node at path with its subtree, planets and lights included
+  void removeNode(std::string const& path);
+  // node at a path like /root/earth holder/moon, nullptr if there is none
+  std::shared_ptr<Node> findNode(std::string const& path)const;
 
   // add planet
   void addPlanet(std::shared_ptr<GeometryNode> planet);
@@ -36,11 +46,18 @@ class SceneGraph {
   // recursive print method for individual node
   std::string printNode(std::shared_ptr<Node> const& node)const;
 
+  // add or remove node and its subtree from the path index
+  void indexNode(std::shared_ptr<Node> const& node);
+  void unindexNode(std::shared_ptr<Node> const& node);
+  // drop planets and lights of the subtree
+  void forgetNode(std::shared_ptr<Node> const& node);
+
   // attributes
   std::string name_;
   std::shared_ptr<Node> rootNode_;
   std::list<std::shared_ptr<GeometryNode>> planets_;
   std::list<std::shared_ptr<PointLightNode>> lightNodes_;
+  std::unordered_map<std::string, std::shared_ptr<Node>> nodes_;
 };
 
 #endif
\ No newline at end of file
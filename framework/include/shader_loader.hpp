@@ -3,15 +3,34 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
 #include <glbinding/gl/enum.h>
 using namespace gl;
 
 namespace shader_loader {
-  // compile shader
-  unsigned shader(std::string const& file_path, GLenum shader_type);
+  // compile shader, defines are injected after the version directive
+  unsigned shader(std::string const& file_path, GLenum shader_type, std::vector<std::string> const& defines = std::vector<std::string>{});
   // create program from given list of stages
-  unsigned program(std::map<GLenum, std::string> const&);
+  // if a cache path is given, linked binaries are stored there and reused when sources and driver match
+  unsigned program(std::map<GLenum, std::string> const&, std::vector<std::string> const& defines = std::vector<std::string>{}, std::string const& cache_path = "");
+
+  // program whose compilation may still run on driver threads
+  struct pending_program {
+    unsigned handle = 0;
+    // stage objects, empty if the program came from the binary cache
+    std::map<GLenum, unsigned> shaders{};
+    std::map<GLenum, std::string> names{};
+    std::string binary_path{};
+  };
+  // issue compilation and linking without waiting for the result
+  pending_program begin_program(std::map<GLenum, std::string> const&, std::vector<std::string> const& defines = std::vector<std::string>{}, std::string const& cache_path = "");
+  // true when finish_program will not block, needs ARB_parallel_shader_compile
+  bool program_ready(pending_program const& pending);
+  // check status and return linked program, throws on errors
+  unsigned finish_program(pending_program& pending);
+  // free objects of an abandoned compilation
+  void discard_program(pending_program& pending);
 }
 
 #endif
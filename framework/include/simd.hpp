@@ -0,0 +1,117 @@
+#ifndef SIMD_HPP
+#define SIMD_HPP
+
+// thin wrapper over the widest vector instructions enabled at compile time
+// kernels are written once against simd::lanes and fall back to plain floats
+
+#include <cmath>
+#include <cstddef>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace simd {
+
+#if defined(__AVX__)
+
+typedef __m256 lanes;
+static const std::size_t width = 8;
+inline char const* instruction_set() { return "AVX"; }
+
+inline lanes set(float value) { return _mm256_set1_ps(value); }
+inline lanes load(float const* ptr) { return _mm256_loadu_ps(ptr); }
+inline void store(float* ptr, lanes a) { _mm256_storeu_ps(ptr, a); }
+inline lanes add(lanes a, lanes b) { return _mm256_add_ps(a, b); }
+inline lanes sub(lanes a, lanes b) { return _mm256_sub_ps(a, b); }
+inline lanes mul(lanes a, lanes b) { return _mm256_mul_ps(a, b); }
+inline lanes div(lanes a, lanes b) { return _mm256_div_ps(a, b); }
+inline lanes min(lanes a, lanes b) { return _mm256_min_ps(a, b); }
+inline lanes max(lanes a, lanes b) { return _mm256_max_ps(a, b); }
+inline lanes round(lanes a) { return _mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+// magnitude of a with sign of b
+inline lanes copysign(lanes a, lanes b) {
+    lanes sign = _mm256_set1_ps(-0.0f);
+    return _mm256_or_ps(_mm256_andnot_ps(sign, a), _mm256_and_ps(sign, b));
+}
+
+#elif defined(SIMD_SSE2)
+
+typedef __m128 lanes;
+static const std::size_t width = 4;
+inline char const* instruction_set() { return "SSE2"; }
+
+inline lanes set(float value) { return _mm_set1_ps(value); }
+inline lanes load(float const* ptr) { return _mm_loadu_ps(ptr); }
+inline void store(float* ptr, lanes a) { _mm_storeu_ps(ptr, a); }
+inline lanes add(lanes a, lanes b) { return _mm_add_ps(a, b); }
+inline lanes sub(lanes a, lanes b) { return _mm_sub_ps(a, b); }
+inline lanes mul(lanes a, lanes b) { return _mm_mul_ps(a, b); }
+inline lanes div(lanes a, lanes b) { return _mm_div_ps(a, b); }
+inline lanes min(lanes a, lanes b) { return _mm_min_ps(a, b); }
+inline lanes max(lanes a, lanes b) { return _mm_max_ps(a, b); }
+// SSE2 has no round instruction, conversion rounds to nearest
+inline lanes round(lanes a) { return _mm_cvtepi32_ps(_mm_cvtps_epi32(a)); }
+// magnitude of a with sign of b
+inline lanes copysign(lanes a, lanes b) {
+    lanes sign = _mm_set1_ps(-0.0f);
+    return _mm_or_ps(_mm_andnot_ps(sign, a), _mm_and_ps(sign, b));
+}
+
+#else
+
+typedef float lanes;
+static const std::size_t width = 1;
+inline char const* instruction_set() { return "scalar"; }
+
+inline lanes set(float value) { return value; }
+inline lanes load(float const* ptr) { return *ptr; }
+inline void store(float* ptr, lanes a) { *ptr = a; }
+inline lanes add(lanes a, lanes b) { return a + b; }
+inline lanes sub(lanes a, lanes b) { return a - b; }
+inline lanes mul(lanes a, lanes b) { return a * b; }
+inline lanes div(lanes a, lanes b) { return a / b; }
+inline lanes min(lanes a, lanes b) { return a < b ? a : b; }
+inline lanes max(lanes a, lanes b) { return a > b ? a : b; }
+inline lanes round(lanes a) { return std::nearbyint(a); }
+inline lanes copysign(lanes a, lanes b) { return std::copysign(a, b); }
+
+#endif
+
+// a * b + c
+inline lanes madd(lanes a, lanes b, lanes c) { return add(mul(a, b), c); }
+
+// angle wrapped to [-pi, pi]
+inline lanes wrap_angle(lanes x) {
+    lanes turns = round(mul(x, set(0.159154943f)));
+    return sub(x, mul(turns, set(6.28318531f)));
+}
+
+// sine of any angle, odd polynomial after folding into [-pi/2, pi/2]
+// absolute error below 1e-7, enough for single precision
+inline lanes sin(lanes x) {
+    lanes pi = set(3.14159265f);
+    x = wrap_angle(x);
+    // sin(x) = sin(pi - x) = sin(-pi - x)
+    x = min(x, sub(pi, x));
+    x = max(x, sub(sub(set(0.0f), pi), x));
+    lanes x2 = mul(x, x);
+    lanes poly = set(-2.50521084e-8f);
+    poly = madd(poly, x2, set(2.75573192e-6f));
+    poly = madd(poly, x2, set(-1.98412698e-4f));
+    poly = madd(poly, x2, set(8.33333333e-3f));
+    poly = madd(poly, x2, set(-1.66666667e-1f));
+    poly = madd(poly, x2, set(1.0f));
+    return mul(poly, x);
+}
+
+inline lanes cos(lanes x) {
+    return sin(add(x, set(1.57079633f)));
+}
+
+}
+
+#endif
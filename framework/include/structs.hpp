@@ -2,6 +2,8 @@
 #define STRUCTS_HPP
 
 #include <map>
+#include <string>
+#include <vector>
 #include <glbinding/gl/gl.h>
 // use gl definitions from glbinding 
 using namespace gl;
@@ -30,13 +32,16 @@ struct texture_object {
 
 // shader handle and uniform storage
 struct shader_program {
-  shader_program(std::map<GLenum, std::string> paths)
+  shader_program(std::map<GLenum, std::string> paths, std::vector<std::string> defs = std::vector<std::string>{})
    :shader_paths{paths}
+   ,defines{defs}
    ,handle{0}
    {}
 
   // paths to shader sources
   std::map<GLenum, std::string> shader_paths;
+  // preprocessor symbols injected into every stage, select the variant
+  std::vector<std::string> defines;
   // object handle
   GLuint handle;
   // uniform locations mapped to name
@@ -49,12 +54,14 @@ struct framebuffer_object {
 	// handle of framebuffer object
 	GLuint handle = 0;
 
-	// color attachment
+	// first color attachment
 	texture_object color_buffer;
 	GLuint color_handle = 0;
+	// all color attachments in attachment order, starting with color_handle
+	std::vector<GLuint> color_handles;
 
-	// depth attachment
-	GLuint depth_handle;
+	// depth attachment, a texture so later passes can sample it
+	GLuint depth_handle = 0;
 };
 // =====================================================
 
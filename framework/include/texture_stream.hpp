@@ -0,0 +1,42 @@
+#ifndef TEXTURE_STREAM_HPP
+#define TEXTURE_STREAM_HPP
+
+#include "pixel_data.hpp"
+#include "job_system.hpp"
+
+#include <deque>
+#include <mutex>
+#include <string>
+#include <utility>
+
+// decodes image files as jobs, one per file
+// texture objects need the gl context, so finished images are polled and uploaded by the render thread
+class TextureStream {
+public:
+    explicit TextureStream(JobSystem& jobs = JobSystem::shared());
+    // waits for running decodes, requests not started yet are dropped
+    ~TextureStream();
+
+    TextureStream(TextureStream const&) = delete;
+    TextureStream& operator=(TextureStream const&) = delete;
+
+    // queue file for decoding
+    void request(std::string const& file_name);
+    // take one decoded image, false if none is finished
+    // files failing to load are reported on stderr and never returned
+    bool poll(std::string& file_name, pixel_data& image);
+    // requests not returned by poll yet
+    std::size_t getPendingCount() const;
+
+private:
+    void decode(std::string const& file_name);
+
+    JobSystem& jobs_;
+    JobCounter decoding_;
+    std::deque<std::pair<std::string, pixel_data>> finished_;
+    std::size_t pending_;
+    bool stopping_;
+    mutable std::mutex mutex_;
+};
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef TRANSFORM_BATCH_HPP
+#define TRANSFORM_BATCH_HPP
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+
+// matrix kernels over arrays of transforms, vectorized with the instruction set enabled at compile time
+// every kernel has a scalar reference using glm, with identical results up to rounding
+namespace transform_batch {
+// results[i] = parents[i] * locals[i], results may alias either input
+void multiply(glm::fmat4 const* parents, glm::fmat4 const* locals, glm::fmat4* results, std::size_t count);
+void multiply_reference(glm::fmat4 const* parents, glm::fmat4 const* locals, glm::fmat4* results, std::size_t count);
+
+// inverse transpose of the upper 3x3 of view * models[i], padded to a 4x4 matrix
+// only valid for affine transforms, which is all the scene graph holds
+void normal_matrices(glm::fmat4 const& view, glm::fmat4 const* models, glm::fmat4* results, std::size_t count);
+void normal_matrices_reference(glm::fmat4 const& view, glm::fmat4 const* models, glm::fmat4* results, std::size_t count);
+
+// instruction set used by the kernels
+char const* instruction_set();
+}
+
+#endif
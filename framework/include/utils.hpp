@@ -2,12 +2,14 @@
 #define UTILS_HPP
 
 #include <glbinding/gl/types.h>
+#include <glbinding/gl/extension.h>
 // use gl definitions from glbinding 
 using namespace gl;
 
 #include <glm/gtc/type_precision.hpp>
 
 #include <map>
+#include <string>
 #include <vector>
 
 struct pixel_data;
@@ -34,8 +36,20 @@ std::string read_file(std::string const& name);
 // return path to resources depending on cmdline args
 std::string read_resource_path(int argc, char* argv[]);
 
+// create directory if it does not exist yet, returns success
+bool make_directory(std::string const& path);
+
+// check whether current context supports the extension, result is cached
+bool supports_extension(GLextension extension);
+// check whether current context has at least the given version
+bool supports_version(unsigned major, unsigned minor);
+
 // calculate Vert+ FOV projection matrix
 glm::fmat4 calculate_projection_matrix(float aspect);
+
+// one sided gaussian of given radius for a separable blur
+// neighbouring texels are merged into one linearly filtered tap, tap 0 is the center
+void gaussian_linear_taps(unsigned radius, std::vector<float>& offsets, std::vector<float>& weights);
 }
 
 #endif
@@ -3,12 +3,15 @@
 
 #include <glm/gtc/type_precision.hpp>
 
+#include <cstddef>
+
 //dont load gl bindings from glfw
 #define GLFW_INCLUDE_NONE
 #include <GLFW/glfw3.h>
 
 // forward declarations
 class Application;
+class FramePacer;
 struct GLFWwindow;
 
 namespace window_handler {
@@ -19,7 +22,9 @@ void set_callback_object(GLFWwindow* window, Application* app);
 // free resources
 void close_and_quit(GLFWwindow* window, int status);
     // calculate fps and show in window title
-void show_fps(GLFWwindow* window);
+    // heap allocations of the frame are summed up and shown as well, if they are counted
+    // with a pacer, its mode and the mean and deviation of the frame time are shown
+void show_fps(GLFWwindow* window, std::size_t allocations = 0, FramePacer const* pacer = nullptr);
 }
 
 #endif
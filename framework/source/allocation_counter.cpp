@@ -0,0 +1,77 @@
+#include "allocation_counter.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifndef NDEBUG
+
+static std::atomic<std::size_t> allocations{0};
+
+static void* allocate(std::size_t size) {
+    ++allocations;
+    // zero sized allocations must still return unique pointers
+    void* memory = std::malloc(size > 0 ? size : 1);
+    if (!memory) {
+        throw std::bad_alloc{};
+    }
+    return memory;
+}
+
+// replacements of the global allocation functions, every other form forwards to these
+void* operator new(std::size_t size) {
+    return allocate(size);
+}
+void* operator new[](std::size_t size) {
+    return allocate(size);
+}
+void* operator new(std::size_t size, std::nothrow_t const&) noexcept {
+    try {
+        return allocate(size);
+    }
+    catch (std::bad_alloc&) {
+        return nullptr;
+    }
+}
+void* operator new[](std::size_t size, std::nothrow_t const&) noexcept {
+    try {
+        return allocate(size);
+    }
+    catch (std::bad_alloc&) {
+        return nullptr;
+    }
+}
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+void operator delete[](void* memory) noexcept {
+    std::free(memory);
+}
+void operator delete(void* memory, std::nothrow_t const&) noexcept {
+    std::free(memory);
+}
+void operator delete[](void* memory, std::nothrow_t const&) noexcept {
+    std::free(memory);
+}
+
+#endif
+
+namespace allocation_counter {
+
+bool enabled() {
+#ifndef NDEBUG
+    return true;
+#else
+    return false;
+#endif
+}
+
+std::size_t count() {
+#ifndef NDEBUG
+    return allocations.load();
+#else
+    return 0;
+#endif
+}
+
+}
@@ -12,17 +12,32 @@ using namespace gl;
 #define GLFW_INCLUDE_NONE
 #include <GLFW/glfw3.h>
 
-static void update_shader_programs(std::map<std::string, shader_program>& shaders, bool throwing);
+#include <iostream>
+
+static void update_shader_program(shader_program& program, std::string const& cache_path, bool throwing);
 
 const glm::uvec2 Application::initial_resolution = {1024u, 768u};
 const float Application::initial_aspect_ratio = float(initial_resolution.x) / float(initial_resolution.y);
 
 Application::Application(std::string const& resource_path)
     :m_resource_path{resource_path}
+    ,m_shader_cache_path{resource_path + "shader_cache/"}
     ,m_shaders{}
-{}
+    ,m_pending_programs{}
+    ,m_shader_watcher{}
+    ,m_frame_pacer{}
+{
+    if (!utils::make_directory(m_shader_cache_path)) {
+        // compile without cache
+        m_shader_cache_path.clear();
+    }
+}
 
 Application::~Application() {
+    // free unfinished compilations
+    for (auto& pair : m_pending_programs) {
+        shader_loader::discard_program(pair.second);
+    }
     // free all shader program objects
     for (auto const& pair : m_shaders) {
         glDeleteProgram(pair.second.handle);
@@ -31,7 +46,12 @@ Application::~Application() {
 
 void Application::reloadShaders(bool throwing) {
     // recompile shaders from source files
-    update_shader_programs(m_shaders, throwing);
+    for (auto& pair : m_shaders) {
+        update_shader_program(pair.second, m_shader_cache_path, throwing);
+        for (auto const& stage : pair.second.shader_paths) {
+            m_shader_watcher.watch(stage.second);
+        }
+    }
     // after shader programs are recompiled, uniform locations may change
     updateUniformLocations();
     // upload values to new locations
@@ -48,15 +68,102 @@ void Application::updateUniformLocations() {
     }
 }
 
+void Application::loadShaderProgram(std::string const& name, bool throwing) {
+    shader_program& program = m_shaders.at(name);
+    update_shader_program(program, m_shader_cache_path, throwing);
+    for (auto& uniform : program.u_locs) {
+        uniform.second = utils::glGetUniformLocation(program.handle, uniform.first.c_str());
+    }
+    for (auto const& stage : program.shader_paths) {
+        m_shader_watcher.watch(stage.second);
+    }
+}
+
+void Application::beginShaderCompile(std::string const& name) {
+    auto pending = m_pending_programs.find(name);
+    // sources changed again before the last compilation finished
+    if (pending != m_pending_programs.end()) {
+        shader_loader::discard_program(pending->second);
+        m_pending_programs.erase(pending);
+    }
+
+    shader_program const& program = m_shaders.at(name);
+    try {
+        m_pending_programs[name] = shader_loader::begin_program(program.shader_paths, program.defines, m_shader_cache_path);
+    }
+    catch(std::exception&) {
+        // source unreadable, possibly still being written
+    }
+}
+
+void Application::requestShaderReload() {
+    for (auto const& pair : m_shaders) {
+        beginShaderCompile(pair.first);
+    }
+}
+
+void Application::pollShaderChanges() {
+    // start compiling every program using a changed file
+    for (auto const& path : m_shader_watcher.poll()) {
+        for (auto const& pair : m_shaders) {
+            for (auto const& stage : pair.second.shader_paths) {
+                if (stage.second == path) {
+                    beginShaderCompile(pair.first);
+                    break;
+                }
+            }
+        }
+    }
+
+    bool swapped = false;
+    for (auto pending = m_pending_programs.begin(); pending != m_pending_programs.end(); ) {
+        // keep rendering with the old program until linking is done
+        if (!shader_loader::program_ready(pending->second)) {
+            ++pending;
+            continue;
+        }
+        try {
+            GLuint new_program = shader_loader::finish_program(pending->second);
+            shader_program& program = m_shaders.at(pending->first);
+            glDeleteProgram(program.handle);
+            program.handle = new_program;
+            for (auto& uniform : program.u_locs) {
+                uniform.second = utils::glGetUniformLocation(program.handle, uniform.first.c_str());
+            }
+            swapped = true;
+        }
+        catch(std::exception&) {
+            // dont crash, keep old program and allow another try
+        }
+        pending = m_pending_programs.erase(pending);
+    }
+
+    if (swapped) {
+        // upload values to new locations
+        uploadUniforms();
+    }
+    // keep polling until all compilations are swapped in
+    if (swapped || !m_pending_programs.empty()) {
+        m_frame_pacer.requestRedraw();
+    }
+}
+
 ///////////////////////////// callback functions for window events ////////////
 // handle key input
 void Application::key_callback(GLFWwindow* m_window, int key, int action, int mods) {
+    m_frame_pacer.requestRedraw();
     // handle special keys
     if ((key == GLFW_KEY_ESCAPE || key == GLFW_KEY_Q) && action == GLFW_PRESS) {
         glfwSetWindowShouldClose(m_window, 1);
     }
     else if (key == GLFW_KEY_R && action == GLFW_PRESS) {
-        reloadShaders(false);
+        requestShaderReload();
+    }
+    // cycle how the loop waits between frames
+    else if (key == GLFW_KEY_V && action == GLFW_PRESS) {
+        int next = (int(m_frame_pacer.getMode()) + 1) % int(FramePacer::MODE_COUNT);
+        m_frame_pacer.setMode(FramePacer::mode(next));
+        std::cout << "Frame pacing " << FramePacer::getModeName(m_frame_pacer.getMode()) << std::endl;
     }
     // else pass input to derived class
     else {
@@ -66,6 +173,10 @@ void Application::key_callback(GLFWwindow* m_window, int key, int action, int mo
 
 //handle mouse movement input
 void Application::mouse_callback(GLFWwindow* window, double pos_x, double pos_y) {
+    // resetting the cursor below may report a position without movement
+    if (pos_x != 0.0 || pos_y != 0.0) {
+        m_frame_pacer.requestRedraw();
+    }
     // pass input to derived class
     mouseCallback(pos_x, pos_y);
     // reset cursor pos to receive position delta next frame
@@ -74,37 +185,34 @@ void Application::mouse_callback(GLFWwindow* window, double pos_x, double pos_y)
 
 // handle window resizing
 void Application::resize_callback(unsigned width, unsigned height) {
+    m_frame_pacer.requestRedraw();
     // resize framebuffer
     glViewport(0, 0, width, height);
     // resize fbo attachments
     resizeCallback(width, height);
 }
 ///////////////////////////// local helper functions //////////////////////////
-// update uniform locations
-static void update_shader_programs(std::map<std::string, shader_program>& shaders, bool throwing) {
+// recompile program, keeping the old one if compilation fails
+static void update_shader_program(shader_program& program, std::string const& cache_path, bool throwing) {
     // actual functionality in lambda to allow update with and without throwing
-    auto update_lambda = [](shader_program& program){
+    auto update_lambda = [&cache_path](shader_program& program){
         // throws exception when compiling was unsuccessfull
-        GLuint new_program = shader_loader::program(program.shader_paths);
+        GLuint new_program = shader_loader::program(program.shader_paths, program.defines, cache_path);
         // free old shader program
         glDeleteProgram(program.handle);
         // save new shader program
         program.handle = new_program;
     };
 
-    // reload all shader programs
-    for (auto& pair : shaders) {
-        if (throwing) {
-            update_lambda(pair.second);
+    if (throwing) {
+        update_lambda(program);
+    }
+    else {
+        try {
+            update_lambda(program);
         }
-        else {
-            try {
-                update_lambda(pair.second);
-            }
-            catch(std::exception&) {
-                // dont crash, allow another try
-            }
+        catch(std::exception&) {
+            // dont crash, allow another try
         }
     }
 }
-
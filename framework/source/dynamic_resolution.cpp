@@ -0,0 +1,118 @@
+#include "dynamic_resolution.hpp"
+
+#include "utils.hpp"
+
+#include <glbinding/gl/gl.h>
+// use gl definitions from glbinding
+using namespace gl;
+
+#include <algorithm>
+#include <cmath>
+
+// share of the budget kept free, so small spikes do not immediately cost resolution
+static const double headroom = 0.9;
+// frame times within this band around the target leave the scale alone
+static const double tolerance = 0.1;
+// largest change of the scale per frame, avoids oscillation as measurements lag behind
+static const float max_scale_step = 0.05f;
+
+DynamicResolution::DynamicResolution(float min_scale, float max_scale, double budget)
+    : min_scale_{std::min(min_scale, max_scale)}
+    , max_scale_{max_scale}
+    , scale_{max_scale}
+    , budget_{budget}
+    , frame_time_{0.0}
+    , enabled_{true}
+    // core since 3.3
+    , timer_{utils::supports_version(3, 3) || utils::supports_extension(GLextension::GL_ARB_timer_query)}
+    , queries_{}
+    , frame_{0}
+    , last_frame_{std::chrono::steady_clock::now()}
+{
+    if (timer_) {
+        glGenQueries(GLsizei(query_count), queries_);
+    }
+}
+
+DynamicResolution::~DynamicResolution() {
+    if (timer_) {
+        glDeleteQueries(GLsizei(query_count), queries_);
+    }
+}
+
+void DynamicResolution::beginFrame() {
+    if (!timer_) {
+        auto now = std::chrono::steady_clock::now();
+        double milliseconds = std::chrono::duration<double, std::milli>(now - last_frame_).count();
+        last_frame_ = now;
+        if (frame_++ > 0) {
+            update(milliseconds);
+        }
+        return;
+    }
+
+    // the query issued query_count frames ago is most likely done
+    GLuint query = queries_[frame_ % query_count];
+    if (frame_ >= query_count) {
+        GLuint available = 0;
+        glGetQueryObjectuiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available != 0) {
+            GLuint64 nanoseconds = 0;
+            glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+            update(double(nanoseconds) * 1e-6);
+        }
+    }
+    glBeginQuery(GL_TIME_ELAPSED, query);
+}
+
+void DynamicResolution::endFrame() {
+    if (timer_) {
+        glEndQuery(GL_TIME_ELAPSED);
+        ++frame_;
+    }
+}
+
+void DynamicResolution::update(double milliseconds) {
+    frame_time_ = milliseconds;
+    if (!enabled_ || milliseconds <= 0.0) {
+        return;
+    }
+    double target = budget_ * headroom;
+    if (std::abs(milliseconds - target) < target * tolerance) {
+        return;
+    }
+    // cost grows with the pixel count, the square of the scale
+    float ideal = scale_ * float(std::sqrt(target / milliseconds));
+    float step = std::min(std::max(ideal - scale_, -max_scale_step), max_scale_step);
+    scale_ = std::min(std::max(scale_ + step, min_scale_), max_scale_);
+}
+
+float DynamicResolution::getScale() const {
+    return enabled_ ? scale_ : max_scale_;
+}
+
+glm::uvec2 DynamicResolution::getRenderSize(glm::uvec2 const& full_size) const {
+    float scale = getScale();
+    return glm::max(glm::uvec2{unsigned(std::lround(float(full_size.x) * scale)),
+                               unsigned(std::lround(float(full_size.y) * scale))},
+                    glm::uvec2{1});
+}
+
+bool DynamicResolution::getEnabled() const {
+    return enabled_;
+}
+void DynamicResolution::setEnabled(bool enabled) {
+    enabled_ = enabled;
+}
+double DynamicResolution::getBudget() const {
+    return budget_;
+}
+void DynamicResolution::setBudget(double budget) {
+    budget_ = std::max(budget, 1.0);
+}
+double DynamicResolution::getFrameTime() const {
+    return frame_time_;
+}
+bool DynamicResolution::getTimerSupport() const {
+    return timer_;
+}
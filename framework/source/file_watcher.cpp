@@ -0,0 +1,126 @@
+#include "file_watcher.hpp"
+
+#include <iostream>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#else
+#include <sys/stat.h>
+#endif
+
+// split path into directory and file name
+static std::pair<std::string, std::string> split_path(std::string const& path) {
+    std::size_t separator = path.find_last_of("/\\");
+    if (separator == std::string::npos) {
+        return {".", path};
+    }
+    return {path.substr(0, separator), path.substr(separator + 1)};
+}
+
+#ifdef __linux__
+
+FileWatcher::FileWatcher()
+    : files_{}
+    , inotify_fd_(inotify_init1(IN_NONBLOCK | IN_CLOEXEC))
+    , directories_{}
+{
+    if (inotify_fd_ < 0) {
+        std::cerr << "FileWatcher: inotify unavailable, changes will not be detected" << std::endl;
+    }
+}
+
+FileWatcher::~FileWatcher() {
+    if (inotify_fd_ >= 0) {
+        close(inotify_fd_);
+    }
+}
+
+void FileWatcher::watch(std::string const& path) {
+    if (!files_.insert(path).second || inotify_fd_ < 0) {
+        return;
+    }
+    std::string directory = split_path(path).first;
+    // adding an already watched directory returns its existing descriptor
+    int descriptor = inotify_add_watch(inotify_fd_, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+    if (descriptor < 0) {
+        std::cerr << "FileWatcher: cannot watch " << directory << std::endl;
+        return;
+    }
+    directories_[descriptor] = directory;
+}
+
+std::vector<std::string> FileWatcher::poll() {
+    std::set<std::string> changed{};
+    if (inotify_fd_ < 0) {
+        return {};
+    }
+
+    alignas(inotify_event) char buffer[4096];
+    while (true) {
+        ssize_t length = read(inotify_fd_, buffer, sizeof(buffer));
+        // EAGAIN, no more pending events
+        if (length <= 0) {
+            break;
+        }
+        for (char* ptr = buffer; ptr < buffer + length; ) {
+            inotify_event const* event = reinterpret_cast<inotify_event const*>(ptr);
+            ptr += sizeof(inotify_event) + event->len;
+
+            auto directory = directories_.find(event->wd);
+            if (directory == directories_.end() || event->len == 0) {
+                continue;
+            }
+            std::string path = directory->second + "/" + event->name;
+            if (files_.find(path) != files_.end()) {
+                changed.insert(path);
+            }
+        }
+    }
+    return std::vector<std::string>{changed.begin(), changed.end()};
+}
+
+#else
+
+static std::time_t modification_time(std::string const& path) {
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) {
+        return 0;
+    }
+    return info.st_mtime;
+}
+
+FileWatcher::FileWatcher()
+    : files_{}
+    , modification_times_{}
+    , last_poll_{std::chrono::steady_clock::now()}
+{}
+
+FileWatcher::~FileWatcher() {}
+
+void FileWatcher::watch(std::string const& path) {
+    if (files_.insert(path).second) {
+        modification_times_[path] = modification_time(path);
+    }
+}
+
+std::vector<std::string> FileWatcher::poll() {
+    std::vector<std::string> changed{};
+    // stat calls are not free, check a few times per second
+    auto now = std::chrono::steady_clock::now();
+    if (now - last_poll_ < std::chrono::milliseconds(250)) {
+        return changed;
+    }
+    last_poll_ = now;
+
+    for (auto& entry : modification_times_) {
+        std::time_t time = modification_time(entry.first);
+        if (time != entry.second) {
+            entry.second = time;
+            changed.push_back(entry.first);
+        }
+    }
+    return changed;
+}
+
+#endif
@@ -0,0 +1,137 @@
+#include "frame_pacer.hpp"
+
+//dont load gl bindings from glfw
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+// sleeping wakes up late by about this much, the remainder is spun
+static const std::chrono::microseconds spin_margin{2000};
+
+FramePacer::FramePacer(mode pacing, double frame_rate_cap)
+    : mode_{pacing}
+    , frame_rate_cap_{std::max(frame_rate_cap, 1.0)}
+    , redraw_requested_{true}
+    , deadline_{clock::now()}
+    , last_frame_{clock::now()}
+    , frames_{0}
+    , mean_{0.0}
+    , squared_deviation_{0.0}
+    , window_start_{clock::now()}
+    , last_mean_{0.0}
+    , last_deviation_{0.0}
+{
+    applySwapInterval();
+}
+
+FramePacer::mode FramePacer::getMode() const {
+    return mode_;
+}
+
+void FramePacer::setMode(mode pacing) {
+    mode_ = pacing;
+    deadline_ = clock::now();
+    redraw_requested_ = true;
+    applySwapInterval();
+}
+
+char const* FramePacer::getModeName(mode pacing) {
+    switch (pacing) {
+        case VSYNC:
+            return "vsync";
+        case CAPPED:
+            return "capped";
+        case ADAPTIVE:
+            return "adaptive vsync";
+        case ON_DEMAND:
+            return "on demand";
+        case UNCAPPED:
+            return "uncapped";
+        default:
+            return "unknown";
+    }
+}
+
+double FramePacer::getFrameRateCap() const {
+    return frame_rate_cap_;
+}
+void FramePacer::setFrameRateCap(double frame_rate) {
+    frame_rate_cap_ = std::max(frame_rate, 1.0);
+}
+
+void FramePacer::applySwapInterval() const {
+    int interval = 1;
+    if (mode_ == CAPPED || mode_ == UNCAPPED) {
+        interval = 0;
+    }
+    // negative interval swaps late frames immediately
+    else if (mode_ == ADAPTIVE && (glfwExtensionSupported("WGL_EXT_swap_control_tear")
+                                   || glfwExtensionSupported("GLX_EXT_swap_control_tear"))) {
+        interval = -1;
+    }
+    glfwSwapInterval(interval);
+}
+
+void FramePacer::waitForEvents() {
+    if (mode_ == ON_DEMAND && !redraw_requested_) {
+        glfwWaitEvents();
+    }
+    redraw_requested_ = false;
+}
+
+void FramePacer::requestRedraw() {
+    redraw_requested_ = true;
+}
+
+void FramePacer::waitUntil(clock::time_point deadline) const {
+    auto sleep_end = deadline - spin_margin;
+    if (clock::now() < sleep_end) {
+        std::this_thread::sleep_until(sleep_end);
+    }
+    while (clock::now() < deadline) {
+        std::this_thread::yield();
+    }
+}
+
+void FramePacer::endFrame() {
+    if (mode_ == CAPPED) {
+        auto period = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / frame_rate_cap_));
+        deadline_ += period;
+        auto now = clock::now();
+        // a late frame moves the schedule instead of rushing the following ones
+        if (deadline_ < now) {
+            deadline_ = now;
+        }
+        else {
+            waitUntil(deadline_);
+        }
+    }
+
+    auto now = clock::now();
+    double milliseconds = std::chrono::duration<double, std::milli>(now - last_frame_).count();
+    last_frame_ = now;
+    // welford update, stable without storing the frame times
+    ++frames_;
+    double delta = milliseconds - mean_;
+    mean_ += delta / double(frames_);
+    squared_deviation_ += delta * (milliseconds - mean_);
+
+    if (now - window_start_ >= std::chrono::seconds(1)) {
+        last_mean_ = mean_;
+        last_deviation_ = frames_ > 1 ? std::sqrt(squared_deviation_ / double(frames_ - 1)) : 0.0;
+        frames_ = 0;
+        mean_ = 0.0;
+        squared_deviation_ = 0.0;
+        window_start_ = now;
+    }
+}
+
+double FramePacer::getMeanFrameTime() const {
+    return last_mean_;
+}
+double FramePacer::getFrameTimeDeviation() const {
+    return last_deviation_;
+}
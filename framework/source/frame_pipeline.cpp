@@ -0,0 +1,49 @@
+#include "frame_pipeline.hpp"
+
+#include <chrono>
+
+FramePipeline::FramePipeline(prepare_function const& prepare, JobSystem& jobs)
+    : prepare_{prepare}
+    , jobs_{jobs}
+    , preparing_{}
+    , threaded_{true}
+    , wait_time_{0.0}
+{}
+
+FramePipeline::~FramePipeline() {
+    // an exception of the last preparation can not be thrown from here
+    try {
+        jobs_.wait(preparing_);
+    }
+    catch (...) {
+    }
+}
+
+void FramePipeline::kick(std::size_t slot) {
+    wait();
+    if (!threaded_) {
+        prepare_(slot);
+        return;
+    }
+    jobs_.run("prepare frame", [this, slot]() { prepare_(slot); }, &preparing_);
+}
+
+void FramePipeline::wait() {
+    bool prepared = preparing_.done();
+    auto start = std::chrono::steady_clock::now();
+    jobs_.wait(preparing_);
+    wait_time_ = prepared ? 0.0 : std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool FramePipeline::getThreaded() const {
+    return threaded_;
+}
+
+void FramePipeline::setThreaded(bool threaded) {
+    wait();
+    threaded_ = threaded;
+}
+
+double FramePipeline::getWaitTime() const {
+    return wait_time_;
+}
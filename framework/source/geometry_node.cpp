@@ -25,7 +25,7 @@ GeometryNode::GeometryNode(std::string const &name,
 {}
 
 // get attribute methods
-model GeometryNode::getGeometry() const
+model const &GeometryNode::getGeometry() const
 {
     return geometry_;
 }
@@ -63,7 +63,7 @@ glm::fvec3 GeometryNode::getColor() const
 {
     return color_;
 }
-std::string GeometryNode::getTexture() const {
+std::string const &GeometryNode::getTexture() const {
     return texture_;
 }
 texture_object GeometryNode::getTextureObject() const {
@@ -79,3 +79,9 @@ void GeometryNode::setColor(glm::fvec3 const &color)
 void GeometryNode::setTextureObject(texture_object texture_object){
     texture_object_ = texture_object;
 }
+orbital_elements const& GeometryNode::getOrbit() const {
+    return orbit_;
+}
+void GeometryNode::setOrbit(orbital_elements const& orbit) {
+    orbit_ = orbit;
+}
@@ -0,0 +1,366 @@
+#include "job_system.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+// jobs added to the pool at once, enough for a frame of the largest scenes
+static const std::size_t job_block_size = 1024;
+
+///////////////////////////// JobCounter //////////////////////////////////////
+JobCounter::JobCounter()
+    : pending_{0}
+    , mutex_{}
+    , dependents_{nullptr}
+    , error_{}
+{}
+
+bool JobCounter::done() const {
+    return pending_.load(std::memory_order_acquire) == 0;
+}
+
+///////////////////////////// JobFunction /////////////////////////////////////
+JobFunction::JobFunction()
+    : storage_{}
+    , invoke_{nullptr}
+    , destroy_{nullptr}
+{}
+
+JobFunction::~JobFunction() {
+    reset();
+}
+
+void JobFunction::reset() {
+    if (destroy_ != nullptr) {
+        destroy_(&storage_);
+    }
+    invoke_ = nullptr;
+    destroy_ = nullptr;
+}
+
+void JobFunction::operator()() {
+    invoke_(&storage_);
+}
+
+///////////////////////////// WorkStealingDeque ///////////////////////////////
+WorkStealingDeque::WorkStealingDeque()
+    : top_{0}
+    , bottom_{0}
+{
+    for (auto& task : jobs_) {
+        task.store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+bool WorkStealingDeque::push(job* task) {
+    std::int64_t bottom = bottom_.load(std::memory_order_relaxed);
+    std::int64_t top = top_.load(std::memory_order_acquire);
+    if (bottom - top >= std::int64_t(capacity)) {
+        return false;
+    }
+    jobs_[std::size_t(bottom) & (capacity - 1)].store(task, std::memory_order_relaxed);
+    // the job is visible before thieves see the new bottom
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(bottom + 1, std::memory_order_relaxed);
+    return true;
+}
+
+job* WorkStealingDeque::pop() {
+    std::int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+    bottom_.store(bottom, std::memory_order_relaxed);
+    // thieves must see the reserved bottom before top is read
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::int64_t top = top_.load(std::memory_order_relaxed);
+    if (top > bottom) {
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    job* task = jobs_[std::size_t(bottom) & (capacity - 1)].load(std::memory_order_relaxed);
+    if (top == bottom) {
+        // last job, a thief may take it at the same time
+        if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            task = nullptr;
+        }
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+    }
+    return task;
+}
+
+job* WorkStealingDeque::steal() {
+    std::int64_t top = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::int64_t bottom = bottom_.load(std::memory_order_acquire);
+    if (top >= bottom) {
+        return nullptr;
+    }
+    job* task = jobs_[std::size_t(top) & (capacity - 1)].load(std::memory_order_relaxed);
+    if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        return nullptr;
+    }
+    return task;
+}
+
+///////////////////////////// JobSystem ///////////////////////////////////////
+JobSystem::JobSystem(unsigned workers)
+    : deques_{}
+    , shared_front_{nullptr}
+    , shared_back_{nullptr}
+    , shared_mutex_{}
+    , job_blocks_{}
+    , free_jobs_{nullptr}
+    , pool_mutex_{}
+    , queued_{0}
+    , stopping_{false}
+    , sleep_mutex_{}
+    , sleep_signal_{}
+    , tracing_{false}
+    , trace_start_{clock::now()}
+    , trace_{}
+    , trace_mutex_{}
+    , workers_{}
+{
+    if (workers == 0) {
+        // the main thread is busy with gl
+        workers = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+    }
+    for (unsigned i = 0; i < workers; ++i) {
+        deques_.emplace_back(new WorkStealingDeque{});
+    }
+    addJobs(job_block_size);
+    // no job can be queued before the constructor returns, so workers never see a partial vector
+    for (unsigned i = 0; i < workers; ++i) {
+        workers_.emplace_back(&JobSystem::work, this, std::size_t(i));
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock{sleep_mutex_};
+        stopping_ = true;
+    }
+    sleep_signal_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+JobSystem& JobSystem::shared() {
+    static JobSystem jobs{};
+    return jobs;
+}
+
+void JobSystem::wait(JobCounter& counter) {
+    std::size_t worker = workerIndex();
+    while (!counter.done()) {
+        // a waiting worker would otherwise block a thread the awaited jobs may need
+        job* task = worker < workers_.size() ? find(worker) : nullptr;
+        if (task != nullptr) {
+            execute(task, worker);
+        }
+        else {
+            std::this_thread::yield();
+        }
+    }
+    std::lock_guard<std::mutex> lock{counter.mutex_};
+    if (counter.error_) {
+        std::exception_ptr error = counter.error_;
+        counter.error_ = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+unsigned JobSystem::getWorkerCount() const {
+    return unsigned(workers_.size());
+}
+
+void JobSystem::setTracing(bool tracing) {
+    std::lock_guard<std::mutex> lock{trace_mutex_};
+    if (tracing && !tracing_.load()) {
+        trace_.clear();
+        trace_start_ = clock::now();
+    }
+    tracing_.store(tracing);
+}
+
+bool JobSystem::getTracing() const {
+    return tracing_.load();
+}
+
+void JobSystem::writeTrace(std::string const& path) const {
+    std::ofstream file{path, std::ios::out | std::ios::trunc};
+    if (!file) {
+        throw std::logic_error("job system: cannot write " + path);
+    }
+    std::lock_guard<std::mutex> lock{trace_mutex_};
+    // complete events in microseconds, one track per worker
+    file << "{\"traceEvents\":[";
+    for (std::size_t i = 0; i < trace_.size(); ++i) {
+        trace_event const& event = trace_[i];
+        auto start = std::chrono::duration_cast<std::chrono::microseconds>(event.start - trace_start_).count();
+        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(event.end - event.start).count();
+        file << (i > 0 ? ",\n" : "\n") << "{\"name\":\"" << event.name << "\",\"cat\":\"job\",\"ph\":\"X\",\"ts\":"
+             << start << ",\"dur\":" << duration << ",\"pid\":0,\"tid\":" << event.thread << "}";
+    }
+    file << "\n],\"displayTimeUnit\":\"ms\"}" << std::endl;
+}
+
+void JobSystem::work(std::size_t worker) {
+    while (true) {
+        job* task = find(worker);
+        if (task != nullptr) {
+            execute(task, worker);
+            continue;
+        }
+        // jobs queued after the check increment the count before notifying, so the wakeup is not lost
+        std::unique_lock<std::mutex> lock{sleep_mutex_};
+        sleep_signal_.wait(lock, [this] { return stopping_ || queued_.load() > 0; });
+        if (stopping_ && queued_.load() == 0) {
+            return;
+        }
+    }
+}
+
+std::size_t JobSystem::workerIndex() const {
+    std::thread::id id = std::this_thread::get_id();
+    for (std::size_t i = 0; i < workers_.size(); ++i) {
+        if (workers_[i].get_id() == id) {
+            return i;
+        }
+    }
+    return workers_.size();
+}
+
+job* JobSystem::allocate() {
+    std::lock_guard<std::mutex> lock{pool_mutex_};
+    if (free_jobs_ == nullptr) {
+        addJobs(job_block_size);
+    }
+    job* task = free_jobs_;
+    free_jobs_ = task->next;
+    return task;
+}
+
+void JobSystem::release(job* task) {
+    std::lock_guard<std::mutex> lock{pool_mutex_};
+    task->next = free_jobs_;
+    free_jobs_ = task;
+}
+
+void JobSystem::addJobs(std::size_t count) {
+    job_blocks_.emplace_back(new job[count]);
+    job* block = job_blocks_.back().get();
+    for (std::size_t i = 0; i < count; ++i) {
+        block[i].next = i + 1 < count ? &block[i + 1] : free_jobs_;
+    }
+    free_jobs_ = block;
+}
+
+void JobSystem::schedule(job* task) {
+    queued_.fetch_add(1);
+    std::size_t worker = workerIndex();
+    if (worker == workers_.size() || !deques_[worker]->push(task)) {
+        std::lock_guard<std::mutex> lock{shared_mutex_};
+        task->next = nullptr;
+        if (shared_back_ != nullptr) {
+            shared_back_->next = task;
+        }
+        else {
+            shared_front_ = task;
+        }
+        shared_back_ = task;
+    }
+    {
+        // a worker between checking the count and sleeping holds the lock
+        std::lock_guard<std::mutex> lock{sleep_mutex_};
+    }
+    sleep_signal_.notify_one();
+}
+
+void JobSystem::schedule(job* task, JobCounter& dependency) {
+    {
+        // finish takes the dependents under the same lock after the count reached zero, so none is missed
+        std::lock_guard<std::mutex> lock{dependency.mutex_};
+        if (!dependency.done()) {
+            task->next = dependency.dependents_;
+            dependency.dependents_ = task;
+            return;
+        }
+    }
+    schedule(task);
+}
+
+job* JobSystem::find(std::size_t worker) {
+    job* task = deques_[worker]->pop();
+    if (task == nullptr) {
+        std::lock_guard<std::mutex> lock{shared_mutex_};
+        if (shared_front_ != nullptr) {
+            task = shared_front_;
+            shared_front_ = task->next;
+            if (shared_front_ == nullptr) {
+                shared_back_ = nullptr;
+            }
+        }
+    }
+    for (std::size_t i = 1; task == nullptr && i < deques_.size(); ++i) {
+        task = deques_[(worker + i) % deques_.size()]->steal();
+    }
+    if (task != nullptr) {
+        queued_.fetch_sub(1);
+    }
+    return task;
+}
+
+void JobSystem::execute(job* task, std::size_t worker) {
+    bool tracing = tracing_.load(std::memory_order_relaxed);
+    clock::time_point start = tracing ? clock::now() : clock::time_point{};
+    try {
+        task->function();
+    }
+    catch (...) {
+        if (task->counter != nullptr) {
+            std::lock_guard<std::mutex> lock{task->counter->mutex_};
+            if (!task->counter->error_) {
+                task->counter->error_ = std::current_exception();
+            }
+        }
+        else {
+            try {
+                throw;
+            }
+            catch (std::exception& error) {
+                std::cerr << "Job '" << task->name << "' failed: " << error.what() << std::endl;
+            }
+            catch (...) {
+                std::cerr << "Job '" << task->name << "' failed" << std::endl;
+            }
+        }
+    }
+    // captures are released before waiting threads continue
+    task->function.reset();
+    if (tracing) {
+        std::lock_guard<std::mutex> lock{trace_mutex_};
+        trace_.push_back(trace_event{task->name, worker, start, clock::now()});
+    }
+    if (task->counter != nullptr) {
+        finish(*task->counter);
+    }
+    release(task);
+}
+
+void JobSystem::finish(JobCounter& counter) {
+    // under the lock, wait takes it too before returning, so the counter outlives this
+    job* ready = nullptr;
+    {
+        std::lock_guard<std::mutex> lock{counter.mutex_};
+        if (counter.pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            ready = counter.dependents_;
+            counter.dependents_ = nullptr;
+        }
+    }
+    while (ready != nullptr) {
+        // scheduling relinks the job
+        job* task = ready;
+        ready = task->next;
+        schedule(task);
+    }
+}
@@ -0,0 +1,139 @@
+#include "kepler.hpp"
+
+#include "simd.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cmath>
+
+// newton steps from danby's starting value reach single precision for e < 0.99
+static const unsigned batch_iterations = 6;
+
+// in-plane axes rotated by periapsis argument, inclination and ascending node
+static void plane_axes(orbital_elements const& elements, glm::fvec3& p, glm::fvec3& q) {
+    glm::fmat4 rotation = glm::rotate(glm::fmat4{}, elements.ascending_node, glm::fvec3{0.0f, 1.0f, 0.0f});
+    rotation = glm::rotate(rotation, elements.inclination, glm::fvec3{1.0f, 0.0f, 0.0f});
+    rotation = glm::rotate(rotation, elements.periapsis_argument, glm::fvec3{0.0f, 1.0f, 0.0f});
+    p = glm::fvec3{rotation[0]};
+    q = glm::fvec3{rotation[2]};
+}
+
+// danby's starting value, converges for all eccentricities below 1
+static inline simd::lanes start_value(simd::lanes mean_anomaly, simd::lanes eccentricity) {
+    return simd::add(mean_anomaly, simd::copysign(simd::mul(simd::set(0.85f), eccentricity), mean_anomaly));
+}
+
+static inline simd::lanes newton(simd::lanes mean_anomaly, simd::lanes eccentricity) {
+    simd::lanes one = simd::set(1.0f);
+    simd::lanes anomaly = start_value(mean_anomaly, eccentricity);
+    for (unsigned i = 0; i < batch_iterations; ++i) {
+        simd::lanes f = simd::sub(simd::sub(anomaly, simd::mul(eccentricity, simd::sin(anomaly))), mean_anomaly);
+        simd::lanes df = simd::sub(one, simd::mul(eccentricity, simd::cos(anomaly)));
+        anomaly = simd::sub(anomaly, simd::div(f, df));
+    }
+    return anomaly;
+}
+
+namespace kepler {
+
+std::size_t add(orbit_batch& batch, orbital_elements const& elements) {
+    glm::fvec3 p{};
+    glm::fvec3 q{};
+    plane_axes(elements, p, q);
+
+    float e = elements.eccentricity;
+    batch.mean_anomaly.push_back(elements.mean_anomaly);
+    batch.mean_motion.push_back(elements.mean_motion);
+    batch.eccentricity.push_back(e);
+    batch.semi_major_axis.push_back(elements.semi_major_axis);
+    batch.semi_minor_axis.push_back(elements.semi_major_axis * std::sqrt(1.0f - e * e));
+    batch.p_x.push_back(p.x);
+    batch.p_y.push_back(p.y);
+    batch.p_z.push_back(p.z);
+    batch.q_x.push_back(q.x);
+    batch.q_y.push_back(q.y);
+    batch.q_z.push_back(q.z);
+    batch.x.push_back(0.0f);
+    batch.y.push_back(0.0f);
+    batch.z.push_back(0.0f);
+    return batch.x.size() - 1;
+}
+
+float solve(float mean_anomaly, float eccentricity) {
+    float pi = 3.14159265f;
+    mean_anomaly = std::remainder(mean_anomaly, 2.0f * pi);
+    float anomaly = mean_anomaly + std::copysign(0.85f * eccentricity, mean_anomaly);
+    for (unsigned i = 0; i < 32; ++i) {
+        float step = (anomaly - eccentricity * std::sin(anomaly) - mean_anomaly) / (1.0f - eccentricity * std::cos(anomaly));
+        anomaly -= step;
+        if (std::abs(step) < 1e-6f) {
+            break;
+        }
+    }
+    return anomaly;
+}
+
+void solve(float const* mean_anomaly, float const* eccentricity, float* eccentric_anomaly, std::size_t count) {
+    std::size_t i = 0;
+    for (; i + simd::width <= count; i += simd::width) {
+        simd::lanes m = simd::wrap_angle(simd::load(mean_anomaly + i));
+        simd::store(eccentric_anomaly + i, newton(m, simd::load(eccentricity + i)));
+    }
+    // remainder that does not fill a vector
+    for (; i < count; ++i) {
+        eccentric_anomaly[i] = solve(mean_anomaly[i], eccentricity[i]);
+    }
+}
+
+void solve_reference(float const* mean_anomaly, float const* eccentricity, float* eccentric_anomaly, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+        eccentric_anomaly[i] = solve(mean_anomaly[i], eccentricity[i]);
+    }
+}
+
+void propagate(orbit_batch& batch, float time) {
+    std::size_t count = batch.x.size();
+    simd::lanes t = simd::set(time);
+
+    std::size_t i = 0;
+    for (; i + simd::width <= count; i += simd::width) {
+        simd::lanes e = simd::load(&batch.eccentricity[i]);
+        simd::lanes m = simd::madd(simd::load(&batch.mean_motion[i]), t, simd::load(&batch.mean_anomaly[i]));
+        simd::lanes anomaly = newton(simd::wrap_angle(m), e);
+
+        // coordinates in the orbital plane
+        simd::lanes u = simd::mul(simd::load(&batch.semi_major_axis[i]), simd::sub(simd::cos(anomaly), e));
+        simd::lanes w = simd::mul(simd::load(&batch.semi_minor_axis[i]), simd::sin(anomaly));
+
+        simd::store(&batch.x[i], simd::madd(u, simd::load(&batch.p_x[i]), simd::mul(w, simd::load(&batch.q_x[i]))));
+        simd::store(&batch.y[i], simd::madd(u, simd::load(&batch.p_y[i]), simd::mul(w, simd::load(&batch.q_y[i]))));
+        simd::store(&batch.z[i], simd::madd(u, simd::load(&batch.p_z[i]), simd::mul(w, simd::load(&batch.q_z[i]))));
+    }
+    for (; i < count; ++i) {
+        float e = batch.eccentricity[i];
+        float anomaly = solve(batch.mean_anomaly[i] + batch.mean_motion[i] * time, e);
+        float u = batch.semi_major_axis[i] * (std::cos(anomaly) - e);
+        float w = batch.semi_minor_axis[i] * std::sin(anomaly);
+        batch.x[i] = u * batch.p_x[i] + w * batch.q_x[i];
+        batch.y[i] = u * batch.p_y[i] + w * batch.q_y[i];
+        batch.z[i] = u * batch.p_z[i] + w * batch.q_z[i];
+    }
+}
+
+glm::fvec3 position(orbital_elements const& elements, float time) {
+    glm::fvec3 p{};
+    glm::fvec3 q{};
+    plane_axes(elements, p, q);
+
+    float e = elements.eccentricity;
+    float anomaly = solve(elements.mean_anomaly + elements.mean_motion * time, e);
+    float u = elements.semi_major_axis * (std::cos(anomaly) - e);
+    float w = elements.semi_major_axis * std::sqrt(1.0f - e * e) * std::sin(anomaly);
+    return u * p + w * q;
+}
+
+char const* instruction_set() {
+    return simd::instruction_set();
+}
+
+}
@@ -0,0 +1,230 @@
+#include "mesh_registry.hpp"
+
+#include "utils.hpp"
+
+#include <glbinding/gl/gl.h>
+// use gl definitions from glbinding
+using namespace gl;
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+// position, normal and texture coordinate
+static const std::size_t vertex_components = 8;
+
+MeshRegistry::MeshRegistry()
+    : vertices_{}
+    , indices_{}
+    , ranges_{}
+    , uploaded_meshes_{0}
+    , vertex_array_{0}
+    , vertex_buffer_{0}
+    , element_buffer_{0}
+    , draw_index_buffer_{0}
+    , draw_index_count_{0}
+    , indirect_buffer_{0}
+    , commands_{}
+    , draw_calls_{0}
+    // base instance in the commands selects the draw data, core since 4.3
+    , indirect_{utils::supports_version(4, 3)
+                || (utils::supports_extension(GLextension::GL_ARB_multi_draw_indirect)
+                    && utils::supports_extension(GLextension::GL_ARB_base_instance))}
+{
+    glGenVertexArrays(1, &vertex_array_);
+    glBindVertexArray(vertex_array_);
+
+    glGenBuffers(1, &vertex_buffer_);
+    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_);
+    GLsizei stride = GLsizei(vertex_components * sizeof(GLfloat));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, nullptr);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(GLfloat)));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(6 * sizeof(GLfloat)));
+
+    // one value per instance, a single entry until commands are set
+    glGenBuffers(1, &draw_index_buffer_);
+    glBindBuffer(GL_ARRAY_BUFFER, draw_index_buffer_);
+    GLint first = 0;
+    glBufferData(GL_ARRAY_BUFFER, sizeof(GLint), &first, GL_STATIC_DRAW);
+    draw_index_count_ = 1;
+    glEnableVertexAttribArray(3);
+    glVertexAttribIPointer(3, 1, GL_INT, 0, nullptr);
+    glVertexAttribDivisor(3, 1);
+
+    // element buffer binding is stored in the vertex array
+    glGenBuffers(1, &element_buffer_);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, element_buffer_);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    if (indirect_) {
+        glGenBuffers(1, &indirect_buffer_);
+    }
+}
+
+MeshRegistry::~MeshRegistry() {
+    glDeleteBuffers(1, &indirect_buffer_);
+    glDeleteBuffers(1, &element_buffer_);
+    glDeleteBuffers(1, &draw_index_buffer_);
+    glDeleteBuffers(1, &vertex_buffer_);
+    glDeleteVertexArrays(1, &vertex_array_);
+}
+
+std::size_t MeshRegistry::add(model const& mesh) {
+    if (mesh.offsets.find(model::POSITION) == mesh.offsets.end()) {
+        throw std::logic_error("mesh registry: model without positions");
+    }
+    std::size_t stride = std::size_t(mesh.vertex_bytes) / sizeof(GLfloat);
+
+    mesh_range range{};
+    range.first_index = GLuint(indices_.size());
+    range.base_vertex = GLint(vertices_.size() / vertex_components);
+    range.vertex_count = GLuint(mesh.vertex_num);
+
+    // interleave into the shared layout, absent attributes stay zero
+    std::size_t begin = vertices_.size();
+    vertices_.resize(begin + mesh.vertex_num * vertex_components, 0.0f);
+    std::size_t target_offset = 0;
+    for (model::attribute const& attribute : {model::POSITION, model::NORMAL, model::TEXCOORD}) {
+        auto offset = mesh.offsets.find(attribute);
+        if (offset != mesh.offsets.end()) {
+            std::size_t source_offset = std::size_t(reinterpret_cast<std::uintptr_t>(offset->second)) / sizeof(GLfloat);
+            for (std::size_t vertex = 0; vertex < mesh.vertex_num; ++vertex) {
+                std::memcpy(&vertices_[begin + vertex * vertex_components + target_offset],
+                            &mesh.data[vertex * stride + source_offset],
+                            std::size_t(attribute.components) * sizeof(GLfloat));
+            }
+        }
+        target_offset += std::size_t(attribute.components);
+    }
+
+    // models without index buffer are drawn in vertex order
+    if (mesh.indices.empty()) {
+        for (std::size_t vertex = 0; vertex < mesh.vertex_num; ++vertex) {
+            indices_.push_back(GLuint(vertex));
+        }
+    }
+    else {
+        indices_.insert(indices_.end(), mesh.indices.begin(), mesh.indices.end());
+    }
+    range.index_count = GLuint(indices_.size()) - range.first_index;
+
+    ranges_.push_back(range);
+    return ranges_.size() - 1;
+}
+
+mesh_range const& MeshRegistry::getRange(std::size_t mesh) const {
+    return ranges_.at(mesh);
+}
+
+std::size_t MeshRegistry::getMeshCount() const {
+    return ranges_.size();
+}
+
+draw_elements_indirect_command MeshRegistry::makeCommand(std::size_t mesh, GLuint base_instance) const {
+    mesh_range const& range = ranges_.at(mesh);
+    draw_elements_indirect_command command{};
+    command.count = range.index_count;
+    command.instance_count = 1;
+    command.first_index = range.first_index;
+    command.base_vertex = range.base_vertex;
+    command.base_instance = base_instance;
+    return command;
+}
+
+void MeshRegistry::upload() {
+    if (uploaded_meshes_ == ranges_.size()) {
+        return;
+    }
+    // meshes are added at startup, so everything is reuploaded instead of growing in place
+    // indices go through the copy target, the element binding belongs to whatever vertex array is bound
+    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_);
+    glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(sizeof(GLfloat) * vertices_.size()), vertices_.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, element_buffer_);
+    glBufferData(GL_COPY_WRITE_BUFFER, GLsizeiptr(sizeof(GLuint) * indices_.size()), indices_.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    uploaded_meshes_ = ranges_.size();
+}
+
+void MeshRegistry::bind() {
+    upload();
+    glBindVertexArray(vertex_array_);
+}
+
+GLuint MeshRegistry::getVertexArray() const {
+    return vertex_array_;
+}
+
+void MeshRegistry::draw(std::size_t mesh) const {
+    mesh_range const& range = ranges_.at(mesh);
+    glDrawElementsBaseVertex(GL_TRIANGLES, GLsizei(range.index_count), GL_UNSIGNED_INT,
+                             (void*)(sizeof(GLuint) * range.first_index), range.base_vertex);
+}
+
+void MeshRegistry::setCommands(std::vector<draw_elements_indirect_command> const& commands) {
+    commands_.assign(commands.begin(), commands.end());
+    draw_calls_ = 0;
+    if (!indirect_) {
+        return;
+    }
+
+    // instanced attribute reads at the base instance, so indices must cover the largest one
+    std::size_t draw_indices = 1;
+    for (auto const& command : commands_) {
+        draw_indices = std::max(draw_indices, std::size_t(command.base_instance) + command.instance_count);
+    }
+    if (draw_indices > draw_index_count_) {
+        // doubled to avoid a reallocation for every new body
+        draw_index_count_ = std::max(draw_indices, draw_index_count_ * 2);
+        std::vector<GLint> values(draw_index_count_);
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            values[i] = GLint(i);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, draw_index_buffer_);
+        glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(sizeof(GLint) * values.size()), values.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect_buffer_);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, GLsizeiptr(sizeof(draw_elements_indirect_command) * commands_.size()),
+                 commands_.data(), GL_STREAM_DRAW);
+}
+
+void MeshRegistry::drawCommands(std::size_t first, std::size_t count, GLint draw_offset_location) const {
+    if (count == 0) {
+        return;
+    }
+    if (indirect_) {
+        // draw index comes from the base instance of each command
+        glUniform1i(draw_offset_location, 0);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect_buffer_);
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+                                    (void*)(sizeof(draw_elements_indirect_command) * first), GLsizei(count), 0);
+        ++draw_calls_;
+        return;
+    }
+
+    // attribute reads its first entry, the uniform carries the base instance instead
+    for (std::size_t i = first; i < first + count; ++i) {
+        draw_elements_indirect_command const& command = commands_[i];
+        glUniform1i(draw_offset_location, GLint(command.base_instance));
+        glDrawElementsInstancedBaseVertex(GL_TRIANGLES, GLsizei(command.count), GL_UNSIGNED_INT,
+                                          (void*)(sizeof(GLuint) * command.first_index),
+                                          GLsizei(command.instance_count), command.base_vertex);
+        ++draw_calls_;
+    }
+}
+
+bool MeshRegistry::getIndirectSupport() const {
+    return indirect_;
+}
+
+std::size_t MeshRegistry::getDrawCallCount() const {
+    return draw_calls_;
+}
@@ -0,0 +1,259 @@
+#include "nbody.hpp"
+#include "job_system.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+// bodies closer than the smallest cell share a leaf instead of splitting forever
+static const int max_depth = 32;
+// below this many bodies queueing a job costs more than it saves
+static const std::size_t min_bodies_per_thread = 512;
+
+NBodySimulation::NBodySimulation(float gravity, float opening_angle, float softening)
+    : gravity_(gravity)
+    , opening_angle_(opening_angle)
+    , softening_(softening)
+    , threads_(0)
+    , forces_valid_(false)
+    , positions_{}
+    , velocities_{}
+    , accelerations_{}
+    , masses_{}
+    , next_body_{}
+    , cells_{}
+{}
+
+std::size_t NBodySimulation::addBody(glm::fvec3 const& position, glm::fvec3 const& velocity, float mass) {
+    positions_.push_back(position);
+    velocities_.push_back(velocity);
+    accelerations_.push_back(glm::fvec3{0.0f});
+    masses_.push_back(mass);
+    next_body_.push_back(-1);
+    forces_valid_ = false;
+    return positions_.size() - 1;
+}
+
+void NBodySimulation::clear() {
+    positions_.clear();
+    velocities_.clear();
+    accelerations_.clear();
+    masses_.clear();
+    next_body_.clear();
+    cells_.clear();
+    forces_valid_ = false;
+}
+
+void NBodySimulation::step(float dt) {
+    if (positions_.empty()) {
+        return;
+    }
+    if (!forces_valid_) {
+        buildTree();
+        computeForces();
+        forces_valid_ = true;
+    }
+
+    float half_step = 0.5f * dt;
+    // kick, drift
+    for (std::size_t i = 0; i < positions_.size(); ++i) {
+        velocities_[i] += accelerations_[i] * half_step;
+        positions_[i] += velocities_[i] * dt;
+    }
+    // forces of the new positions
+    buildTree();
+    computeForces();
+    // kick
+    for (std::size_t i = 0; i < positions_.size(); ++i) {
+        velocities_[i] += accelerations_[i] * half_step;
+    }
+}
+
+glm::fvec3 NBodySimulation::getPosition(std::size_t body) const {
+    return positions_[body];
+}
+glm::fvec3 NBodySimulation::getVelocity(std::size_t body) const {
+    return velocities_[body];
+}
+float NBodySimulation::getMass(std::size_t body) const {
+    return masses_[body];
+}
+std::size_t NBodySimulation::getBodyCount() const {
+    return positions_.size();
+}
+std::size_t NBodySimulation::getCellCount() const {
+    return cells_.size();
+}
+
+void NBodySimulation::setThreadCount(unsigned threads) {
+    threads_ = threads;
+}
+unsigned NBodySimulation::getThreadCount() const {
+    if (threads_ == 0) {
+        // the calling thread computes a range too
+        return JobSystem::shared().getWorkerCount() + 1;
+    }
+    return threads_;
+}
+
+double NBodySimulation::getEnergy() const {
+    double energy = 0.0;
+    for (std::size_t i = 0; i < positions_.size(); ++i) {
+        energy += 0.5 * double(masses_[i]) * double(glm::dot(velocities_[i], velocities_[i]));
+        for (std::size_t j = i + 1; j < positions_.size(); ++j) {
+            glm::fvec3 d = positions_[j] - positions_[i];
+            double distance = std::sqrt(double(glm::dot(d, d)) + double(softening_ * softening_));
+            energy -= double(gravity_) * double(masses_[i]) * double(masses_[j]) / distance;
+        }
+    }
+    return energy;
+}
+
+void NBodySimulation::buildTree() {
+    cells_.clear();
+
+    // cube enclosing all bodies
+    glm::fvec3 lower = positions_.front();
+    glm::fvec3 upper = positions_.front();
+    for (auto const& position : positions_) {
+        lower = glm::min(lower, position);
+        upper = glm::max(upper, position);
+    }
+    glm::fvec3 extent = upper - lower;
+    float half_size = 0.5f * std::max(std::max(extent.x, extent.y), extent.z) * 1.001f + 1e-6f;
+    cells_.push_back(cell{0.5f * (lower + upper), half_size, glm::fvec3{0.0f}, 0.0f, -1, -1, -1});
+
+    for (std::size_t i = 0; i < positions_.size(); ++i) {
+        insert(int(i));
+    }
+
+    // children are always stored behind their parent, so one backwards pass accumulates masses
+    for (std::size_t i = cells_.size(); i-- > 0; ) {
+        cell& current = cells_[i];
+        if (current.children < 0) {
+            for (int body = current.body; body >= 0; body = next_body_[std::size_t(body)]) {
+                current.mass += masses_[std::size_t(body)];
+                current.center_of_mass += masses_[std::size_t(body)] * positions_[std::size_t(body)];
+            }
+        }
+        // weighted sum until now
+        if (current.mass > 0.0f) {
+            current.center_of_mass /= current.mass;
+        }
+        if (current.parent >= 0) {
+            cell& parent = cells_[std::size_t(current.parent)];
+            parent.mass += current.mass;
+            parent.center_of_mass += current.mass * current.center_of_mass;
+        }
+    }
+}
+
+void NBodySimulation::insert(int body) {
+    glm::fvec3 const& position = positions_[std::size_t(body)];
+    int current = 0;
+    int depth = 0;
+    while (true) {
+        if (cells_[std::size_t(current)].children >= 0) {
+            current = childCell(current, position);
+            ++depth;
+            continue;
+        }
+        int resident = cells_[std::size_t(current)].body;
+        // empty leaf, or deep enough to share
+        if (resident < 0 || depth >= max_depth) {
+            next_body_[std::size_t(body)] = resident;
+            cells_[std::size_t(current)].body = body;
+            return;
+        }
+        // occupied leaf, move resident down one level and retry
+        subdivide(current);
+        int child = childCell(current, positions_[std::size_t(resident)]);
+        cells_[std::size_t(child)].body = resident;
+        cells_[std::size_t(current)].body = -1;
+    }
+}
+
+int NBodySimulation::childCell(int index, glm::fvec3 const& position) {
+    cell const& parent = cells_[std::size_t(index)];
+    int octant = (position.x > parent.center.x ? 1 : 0)
+               | (position.y > parent.center.y ? 2 : 0)
+               | (position.z > parent.center.z ? 4 : 0);
+    return parent.children + octant;
+}
+
+void NBodySimulation::subdivide(int index) {
+    // copy, push_back may reallocate
+    cell parent = cells_[std::size_t(index)];
+    float half_size = 0.5f * parent.half_size;
+    cells_[std::size_t(index)].children = int(cells_.size());
+    for (int octant = 0; octant < 8; ++octant) {
+        glm::fvec3 offset{(octant & 1) ? half_size : -half_size,
+                          (octant & 2) ? half_size : -half_size,
+                          (octant & 4) ? half_size : -half_size};
+        cells_.push_back(cell{parent.center + offset, half_size, glm::fvec3{0.0f}, 0.0f, index, -1, -1});
+    }
+}
+
+void NBodySimulation::computeForces() {
+    std::size_t count = positions_.size();
+    std::size_t threads = getThreadCount();
+    std::size_t grain = std::max((count + threads - 1) / threads, min_bodies_per_thread);
+
+    // tree is read only, every job writes its own range of accelerations
+    JobSystem::shared().parallelFor("n-body forces", count, grain, [this](std::size_t begin, std::size_t end) {
+        computeForces(begin, end);
+    });
+}
+
+void NBodySimulation::computeForces(std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; ++i) {
+        accelerations_[i] = acceleration(i);
+    }
+}
+
+glm::fvec3 NBodySimulation::acceleration(std::size_t body) const {
+    glm::fvec3 const& position = positions_[body];
+    float softening2 = softening_ * softening_;
+    float opening2 = opening_angle_ * opening_angle_;
+
+    glm::fvec3 sum{0.0f};
+    // each level pushes at most 8 cells and pops one
+    int stack[8 * (max_depth + 1)];
+    int size = 0;
+    stack[size++] = 0;
+    while (size > 0) {
+        cell const& current = cells_[std::size_t(stack[--size])];
+        if (current.mass <= 0.0f) {
+            continue;
+        }
+
+        if (current.children < 0) {
+            // leaves are summed exactly
+            for (int other = current.body; other >= 0; other = next_body_[std::size_t(other)]) {
+                if (std::size_t(other) == body) {
+                    continue;
+                }
+                glm::fvec3 d = positions_[std::size_t(other)] - position;
+                float distance2 = glm::dot(d, d) + softening2;
+                sum += d * (masses_[std::size_t(other)] / (distance2 * std::sqrt(distance2)));
+            }
+            continue;
+        }
+
+        glm::fvec3 d = current.center_of_mass - position;
+        float distance2 = glm::dot(d, d);
+        float size2 = 4.0f * current.half_size * current.half_size;
+        // far enough away, whole cell acts as one mass
+        if (size2 < opening2 * distance2) {
+            distance2 += softening2;
+            sum += d * (current.mass / (distance2 * std::sqrt(distance2)));
+        }
+        else {
+            for (int octant = 0; octant < 8; ++octant) {
+                stack[size++] = current.children + octant;
+            }
+        }
+    }
+    return gravity_ * sum;
+}
@@ -2,9 +2,9 @@
 
 Node::Node()
     : name_("root")
-    , parent_(nullptr)
+    , parent_()
     , children_()
-    , path_("")
+    , path_("/root")
     , depth_(0)
     , worldTransform_(glm::fmat4(1))
     , localTransform_(glm::fmat4(1))
@@ -14,7 +14,7 @@ Node::Node(std::string const &name,
            glm::fmat4 const &localTansform)
     : name_(name)
     , parent_(parent)
-    , path_("")
+    , path_(parent->getPath() + "/" + name)
     , depth_(parent->getDepth() + 1)
     , localTransform_(localTansform)
 {
@@ -36,31 +36,31 @@ Node::Node(std::string const &name,
 }
 
 // get attribute methods
-std::string Node::getName()
+std::string const &Node::getName() const
 {
     return name_;
 }
-std::shared_ptr<Node> Node::getParent()
+std::shared_ptr<Node> Node::getParent() const
 {
-    return parent_;
+    return parent_.lock();
 }
-std::list<std::shared_ptr<Node>> Node::getChildren()
+std::list<std::shared_ptr<Node>> const &Node::getChildren() const
 {
     return children_;
 }
-std::string Node::getPath()
+std::string const &Node::getPath() const
 {
     return path_;
 }
-int Node::getDepth()
+int Node::getDepth() const
 {
     return depth_;
 }
-glm::fmat4 Node::getWorldTransform()
+glm::fmat4 const &Node::getWorldTransform() const
 {
     return worldTransform_;
 }
-glm::fmat4 Node::getLocalTransform()
+glm::fmat4 const &Node::getLocalTransform() const
 {
     return localTransform_;
 }
@@ -83,7 +83,7 @@ float Node::getDistance() const
 {
     return 1.0f;
 }
-bool Node::getIsLight()
+bool Node::getIsLight() const
 {
     return isLight_;
 }
@@ -92,6 +92,9 @@ bool Node::getIsLight()
 void Node::setParent(std::shared_ptr<Node> const &parent)
 {
     parent_ = parent;
+    updatePath();
+    // the world transform follows the new parent
+    setLocalTransform(localTransform_);
 }
 void Node::setWorldTransform(glm::fmat4 const &worldTransform)
 {
@@ -100,17 +103,21 @@ void Node::setWorldTransform(glm::fmat4 const &worldTransform)
     }
     worldTransform_ = worldTransform * localTransform_;
 }
+void Node::assignWorldTransform(glm::fmat4 const &worldTransform)
+{
+    worldTransform_ = worldTransform;
+}
 void Node::setLocalTransform(glm::fmat4 const &localTransform)
 {
     localTransform_ = localTransform;
 
     if (depth_ != 0) {
-        worldTransform_ = parent_->getWorldTransform() * localTransform_;
+        worldTransform_ = getParent()->getWorldTransform() * localTransform_;
     } else {
         worldTransform_ = localTransform_;
     }
 
-    for (auto child : children_) {
+    for (auto const &child : children_) {
         child->setWorldTransform(worldTransform_);
     }
 }
@@ -122,7 +129,7 @@ void Node::setIsLight(bool isLight)
 // get one specific child
 std::shared_ptr<Node> Node::getChild(std::string const &childName)
 {
-    for (std::shared_ptr<Node> node : children_) {
+    for (auto const &node : children_) {
         if (node->getName() == childName) {
             return node;
         }
@@ -139,9 +146,22 @@ void Node::addChild(std::shared_ptr<Node> const &node)
 // remove one child
 void Node::removeChild(std::string const &childName)
 {
-    for (std::shared_ptr<Node> child : children_) {
-        if (child->getName().compare(childName) == 0) {
-            children_.remove(child);
-        }
+    children_.remove_if([&childName](std::shared_ptr<Node> const &child) {
+        return child->getName() == childName;
+    });
+}
+void Node::removeChild(std::shared_ptr<Node> const &child)
+{
+    children_.remove(child);
+}
+
+// path of the parent followed by the own name and the depth below it, passed on to the subtree
+void Node::updatePath()
+{
+    std::shared_ptr<Node> parent = getParent();
+    path_ = (parent ? parent->getPath() : "") + "/" + name_;
+    depth_ = parent ? parent->getDepth() + 1 : 0;
+    for (auto const &child : children_) {
+        child->updatePath();
     }
 }
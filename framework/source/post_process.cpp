@@ -0,0 +1,671 @@
+#include "post_process.hpp"
+
+#include "utils.hpp"
+
+#include <glbinding/gl/gl.h>
+// use gl definitions from glbinding
+using namespace gl;
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <set>
+
+// size of the weight arrays in blur.frag
+static const unsigned max_blur_taps = 16;
+// bloom levels are stored without alpha, but above 1
+static const GLenum bloom_format = GL_R11F_G11F_B10F;
+// luminance is averaged over this many texels per side, a power of two so every mip halves exactly
+static const GLsizei luminance_size = 256;
+// fraction of the difference to the measured luminance the exposure closes per second
+static const float adaptation_rate = 1.5f;
+
+///////////////////////////// PostEffect //////////////////////////////////////
+PostEffect::PostEffect(std::string const& name, bool enabled)
+    : name_(name)
+    , enabled_(enabled)
+{}
+
+PostEffect::~PostEffect() {}
+
+std::string const& PostEffect::getName() const {
+    return name_;
+}
+bool PostEffect::getEnabled() const {
+    return enabled_;
+}
+void PostEffect::setEnabled(bool enabled) {
+    enabled_ = enabled;
+}
+
+std::string PostEffect::getDefine() const {
+    return "";
+}
+void PostEffect::addUniforms(shader_program& program) const {}
+void PostEffect::uploadUniforms(shader_program const& program) const {}
+void PostEffect::addPrograms(std::map<std::string, shader_program>& shaders, std::string const& shader_path) const {}
+void PostEffect::uploadProgramUniforms(std::map<std::string, shader_program> const& shaders, glm::uvec2 const& size) const {}
+void PostEffect::execute(PostProcessChain const& chain, GLuint input, GLuint output, glm::uvec2 const& size) const {}
+
+///////////////////////////// PixelEffect /////////////////////////////////////
+PixelEffect::PixelEffect(std::string const& name, std::string const& define, bool enabled)
+    : PostEffect(name, enabled)
+    , define_(define)
+{}
+
+bool PixelEffect::isFusible() const {
+    return true;
+}
+std::string PixelEffect::getDefine() const {
+    return define_;
+}
+
+///////////////////////////// GaussianBlurEffect //////////////////////////////
+GaussianBlurEffect::GaussianBlurEffect(std::string const& name, unsigned radius, bool enabled)
+    : PostEffect(name, enabled)
+    , radius_(std::min(std::max(radius, 1u), getMaxRadius()))
+{}
+
+bool GaussianBlurEffect::isFusible() const {
+    return false;
+}
+
+void GaussianBlurEffect::addPrograms(std::map<std::string, shader_program>& shaders, std::string const& shader_path) const {
+    // one program per blur, each holds its own kernel
+    if (shaders.find(getName()) != shaders.end()) {
+        return;
+    }
+    shaders.emplace(getName(), shader_program{{{GL_VERTEX_SHADER, shader_path + "screen_quad.vert"},
+                                               {GL_FRAGMENT_SHADER, shader_path + "blur.frag"}},
+                                              {"MAX_BLUR_TAPS " + std::to_string(max_blur_taps)}});
+    shader_program& program = shaders.at(getName());
+    program.u_locs["screen_Texture"] = -1;
+    program.u_locs["texture_Size"] = -1;
+    program.u_locs["blur_Direction"] = -1;
+    program.u_locs["blur_Taps"] = -1;
+    program.u_locs["blur_Offsets"] = -1;
+    program.u_locs["blur_Weights"] = -1;
+}
+
+void GaussianBlurEffect::uploadProgramUniforms(std::map<std::string, shader_program> const& shaders, glm::uvec2 const& size) const {
+    std::vector<float> offsets{};
+    std::vector<float> weights{};
+    utils::gaussian_linear_taps(radius_, offsets, weights);
+
+    shader_program const& blur = shaders.at(getName());
+    glUseProgram(blur.handle);
+    glUniform1i(blur.u_locs.at("screen_Texture"), 0);
+    glUniform2f(blur.u_locs.at("texture_Size"), float(size.x), float(size.y));
+    glUniform1i(blur.u_locs.at("blur_Taps"), GLint(offsets.size()));
+    glUniform1fv(blur.u_locs.at("blur_Offsets"), GLsizei(offsets.size()), offsets.data());
+    glUniform1fv(blur.u_locs.at("blur_Weights"), GLsizei(weights.size()), weights.data());
+}
+
+void GaussianBlurEffect::execute(PostProcessChain const& chain, GLuint input, GLuint output, glm::uvec2 const& size) const {
+    shader_program const& blur = chain.getProgram(getName());
+    glUseProgram(blur.handle);
+    glActiveTexture(GL_TEXTURE0);
+
+    // horizontal pass into intermediate target
+    render_target* horizontal = chain.acquireTarget(size);
+    glBindFramebuffer(GL_FRAMEBUFFER, horizontal->framebuffer.handle);
+    glUniform2f(blur.u_locs.at("blur_Direction"), 1.0f, 0.0f);
+    glBindTexture(GL_TEXTURE_2D, input);
+    chain.drawQuad();
+
+    // vertical pass into output
+    glBindFramebuffer(GL_FRAMEBUFFER, output);
+    glUniform2f(blur.u_locs.at("blur_Direction"), 0.0f, 1.0f);
+    glBindTexture(GL_TEXTURE_2D, horizontal->framebuffer.color_handle);
+    chain.drawQuad();
+
+    chain.releaseTarget(horizontal);
+}
+
+unsigned GaussianBlurEffect::getRadius() const {
+    return radius_;
+}
+void GaussianBlurEffect::setRadius(unsigned radius) {
+    radius_ = std::min(std::max(radius, 1u), getMaxRadius());
+}
+unsigned GaussianBlurEffect::getMaxRadius() const {
+    // every tap but the center covers two texels
+    return 2 * (max_blur_taps - 1);
+}
+
+///////////////////////////// BloomEffect ///////////////////////////////////
+BloomEffect::BloomEffect(std::string const& name, unsigned levels, bool enabled)
+    : PostEffect(name, enabled)
+    , levels_(std::max(levels, 1u))
+    , threshold_(0.8f)
+    , intensity_(0.6f)
+{}
+
+bool BloomEffect::isFusible() const {
+    return false;
+}
+
+void BloomEffect::addPrograms(std::map<std::string, shader_program>& shaders, std::string const& shader_path) const {
+    if (shaders.find(getName()) != shaders.end()) {
+        return;
+    }
+    // first downsample also applies the threshold
+    shaders.emplace(getName() + " prefilter", shader_program{{{GL_VERTEX_SHADER, shader_path + "screen_quad.vert"},
+                                                              {GL_FRAGMENT_SHADER, shader_path + "bloom_downsample.frag"}},
+                                                             {"PREFILTER"}});
+    shaders.emplace(getName() + " downsample", shader_program{{{GL_VERTEX_SHADER, shader_path + "screen_quad.vert"},
+                                                               {GL_FRAGMENT_SHADER, shader_path + "bloom_downsample.frag"}}});
+    for (std::string const& pass : {getName() + " prefilter", getName() + " downsample"}) {
+        shaders.at(pass).u_locs["screen_Texture"] = -1;
+        shaders.at(pass).u_locs["texel_Size"] = -1;
+    }
+    shaders.at(getName() + " prefilter").u_locs["bloom_Threshold"] = -1;
+
+    shaders.emplace(getName() + " upsample", shader_program{{{GL_VERTEX_SHADER, shader_path + "screen_quad.vert"},
+                                                             {GL_FRAGMENT_SHADER, shader_path + "bloom_upsample.frag"}}});
+    shaders.at(getName() + " upsample").u_locs["screen_Texture"] = -1;
+    shaders.at(getName() + " upsample").u_locs["texel_Size"] = -1;
+
+    shaders.emplace(getName(), shader_program{{{GL_VERTEX_SHADER, shader_path + "screen_quad.vert"},
+                                               {GL_FRAGMENT_SHADER, shader_path + "bloom_composite.frag"}}});
+    shaders.at(getName()).u_locs["screen_Texture"] = -1;
+    shaders.at(getName()).u_locs["bloom_Texture"] = -1;
+    shaders.at(getName()).u_locs["bloom_Intensity"] = -1;
+}
+
+void BloomEffect::uploadProgramUniforms(std::map<std::string, shader_program> const& shaders, glm::uvec2 const& size) const {
+    for (std::string const& pass : {getName() + " prefilter", getName() + " downsample", getName() + " upsample"}) {
+        glUseProgram(shaders.at(pass).handle);
+        glUniform1i(shaders.at(pass).u_locs.at("screen_Texture"), 0);
+    }
+    shader_program const& composite = shaders.at(getName());
+    glUseProgram(composite.handle);
+    glUniform1i(composite.u_locs.at("screen_Texture"), 0);
+    glUniform1i(composite.u_locs.at("bloom_Texture"), 1);
+}
+
+void BloomEffect::execute(PostProcessChain const& chain, GLuint input, GLuint output, glm::uvec2 const& size) const {
+    // halve until the smallest level would be a few texels wide
+    std::vector<render_target*> levels{};
+    glm::uvec2 level_size = size;
+    while (levels.size() < levels_ && level_size.x >= 16 && level_size.y >= 16) {
+        level_size = glm::max(level_size / 2u, glm::uvec2{1});
+        levels.push_back(chain.acquireTarget(level_size, bloom_format));
+    }
+    glActiveTexture(GL_TEXTURE0);
+
+    // bright parts at half resolution, then every level from the one above
+    glm::uvec2 source_size = size;
+    GLuint source = input;
+    for (std::size_t i = 0; i < levels.size(); ++i) {
+        shader_program const& downsample = chain.getProgram(getName() + (i == 0 ? " prefilter" : " downsample"));
+        glUseProgram(downsample.handle);
+        if (i == 0) {
+            glUniform1f(downsample.u_locs.at("bloom_Threshold"), threshold_);
+        }
+        glUniform2f(downsample.u_locs.at("texel_Size"), 1.0f / float(source_size.x), 1.0f / float(source_size.y));
+        glBindFramebuffer(GL_FRAMEBUFFER, levels[i]->framebuffer.handle);
+        glViewport(0, 0, GLsizei(levels[i]->size.x), GLsizei(levels[i]->size.y));
+        glBindTexture(GL_TEXTURE_2D, source);
+        chain.drawQuad();
+        source = levels[i]->framebuffer.color_handle;
+        source_size = levels[i]->size;
+    }
+
+    // blur each level up into the next larger one, adding to what it already holds
+    shader_program const& upsample = chain.getProgram(getName() + " upsample");
+    glUseProgram(upsample.handle);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE);
+    for (std::size_t i = levels.size(); i-- > 1;) {
+        glUniform2f(upsample.u_locs.at("texel_Size"), 1.0f / float(levels[i]->size.x), 1.0f / float(levels[i]->size.y));
+        glBindFramebuffer(GL_FRAMEBUFFER, levels[i - 1]->framebuffer.handle);
+        glViewport(0, 0, GLsizei(levels[i - 1]->size.x), GLsizei(levels[i - 1]->size.y));
+        glBindTexture(GL_TEXTURE_2D, levels[i]->framebuffer.color_handle);
+        chain.drawQuad();
+    }
+    glDisable(GL_BLEND);
+
+    // input with the glow on top
+    shader_program const& composite = chain.getProgram(getName());
+    glUseProgram(composite.handle);
+    glUniform1f(composite.u_locs.at("bloom_Intensity"), levels.empty() ? 0.0f : intensity_);
+    glBindFramebuffer(GL_FRAMEBUFFER, output);
+    glViewport(0, 0, GLsizei(size.x), GLsizei(size.y));
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, levels.empty() ? 0 : levels[0]->framebuffer.color_handle);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, input);
+    chain.drawQuad();
+
+    for (render_target* level : levels) {
+        chain.releaseTarget(level);
+    }
+}
+
+float BloomEffect::getThreshold() const {
+    return threshold_;
+}
+void BloomEffect::setThreshold(float threshold) {
+    threshold_ = std::max(threshold, 0.0f);
+}
+float BloomEffect::getIntensity() const {
+    return intensity_;
+}
+void BloomEffect::setIntensity(float intensity) {
+    intensity_ = std::max(intensity, 0.0f);
+}
+
+///////////////////////////// FxaaEffect ////////////////////////////////////
+FxaaEffect::FxaaEffect(std::string const& name, bool enabled)
+    : PostEffect(name, enabled)
+{}
+
+bool FxaaEffect::isFusible() const {
+    return false;
+}
+
+void FxaaEffect::addPrograms(std::map<std::string, shader_program>& shaders, std::string const& shader_path) const {
+    if (shaders.find(getName()) != shaders.end()) {
+        return;
+    }
+    shaders.emplace(getName(), shader_program{{{GL_VERTEX_SHADER, shader_path + "screen_quad.vert"},
+                                               {GL_FRAGMENT_SHADER, shader_path + "fxaa.frag"}}});
+    shaders.at(getName()).u_locs["screen_Texture"] = -1;
+    shaders.at(getName()).u_locs["texel_Size"] = -1;
+}
+
+void FxaaEffect::uploadProgramUniforms(std::map<std::string, shader_program> const& shaders, glm::uvec2 const& size) const {
+    shader_program const& program = shaders.at(getName());
+    glUseProgram(program.handle);
+    glUniform1i(program.u_locs.at("screen_Texture"), 0);
+    glUniform2f(program.u_locs.at("texel_Size"), 1.0f / float(size.x), 1.0f / float(size.y));
+}
+
+void FxaaEffect::execute(PostProcessChain const& chain, GLuint input, GLuint output, glm::uvec2 const& size) const {
+    glUseProgram(chain.getProgram(getName()).handle);
+    glBindFramebuffer(GL_FRAMEBUFFER, output);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, input);
+    chain.drawQuad();
+}
+
+///////////////////////////// ToneMapEffect /////////////////////////////////
+ToneMapEffect::ToneMapEffect(std::string const& name, bool enabled)
+    : PostEffect(name, enabled)
+    , exposure_(0.0f)
+    , luminance_texture_(0)
+    , luminance_framebuffer_(0)
+    , adapted_textures_{0, 0}
+    , adapted_framebuffers_{0, 0}
+    , current_(0)
+    , last_time_(0.0)
+{}
+
+ToneMapEffect::~ToneMapEffect() {
+    if (luminance_texture_ == 0) {
+        return;
+    }
+    glDeleteFramebuffers(1, &luminance_framebuffer_);
+    glDeleteTextures(1, &luminance_texture_);
+    glDeleteFramebuffers(2, adapted_framebuffers_);
+    glDeleteTextures(2, adapted_textures_);
+}
+
+bool ToneMapEffect::isFusible() const {
+    return false;
+}
+
+void ToneMapEffect::addPrograms(std::map<std::string, shader_program>& shaders, std::string const& shader_path) const {
+    if (shaders.find(getName()) != shaders.end()) {
+        return;
+    }
+    shaders.emplace(getName() + " luminance", shader_program{{{GL_VERTEX_SHADER, shader_path + "screen_quad.vert"},
+                                                              {GL_FRAGMENT_SHADER, shader_path + "luminance.frag"}}});
+    shaders.at(getName() + " luminance").u_locs["screen_Texture"] = -1;
+
+    shaders.emplace(getName() + " adaptation", shader_program{{{GL_VERTEX_SHADER, shader_path + "screen_quad.vert"},
+                                                               {GL_FRAGMENT_SHADER, shader_path + "adaptation.frag"}}});
+    shader_program& adaptation = shaders.at(getName() + " adaptation");
+    adaptation.u_locs["luminance_Texture"] = -1;
+    adaptation.u_locs["adapted_Texture"] = -1;
+    adaptation.u_locs["luminance_Level"] = -1;
+    adaptation.u_locs["adaptation_Factor"] = -1;
+
+    shaders.emplace(getName(), shader_program{{{GL_VERTEX_SHADER, shader_path + "screen_quad.vert"},
+                                               {GL_FRAGMENT_SHADER, shader_path + "tone_map.frag"}}});
+    shaders.at(getName()).u_locs["screen_Texture"] = -1;
+    shaders.at(getName()).u_locs["adapted_Texture"] = -1;
+    shaders.at(getName()).u_locs["exposure_Scale"] = -1;
+}
+
+void ToneMapEffect::uploadProgramUniforms(std::map<std::string, shader_program> const& shaders, glm::uvec2 const& size) const {
+    shader_program const& luminance = shaders.at(getName() + " luminance");
+    glUseProgram(luminance.handle);
+    glUniform1i(luminance.u_locs.at("screen_Texture"), 0);
+
+    // top of the mip chain holds the average
+    shader_program const& adaptation = shaders.at(getName() + " adaptation");
+    glUseProgram(adaptation.handle);
+    glUniform1i(adaptation.u_locs.at("luminance_Texture"), 0);
+    glUniform1i(adaptation.u_locs.at("adapted_Texture"), 1);
+    glUniform1f(adaptation.u_locs.at("luminance_Level"), std::log2(float(luminance_size)));
+
+    shader_program const& tone_map = shaders.at(getName());
+    glUseProgram(tone_map.handle);
+    glUniform1i(tone_map.u_locs.at("screen_Texture"), 0);
+    glUniform1i(tone_map.u_locs.at("adapted_Texture"), 1);
+}
+
+void ToneMapEffect::createTargets() const {
+    glGenTextures(1, &luminance_texture_);
+    glBindTexture(GL_TEXTURE_2D, luminance_texture_);
+    glTexImage2D(GL_TEXTURE_2D, 0, GLint(GL_R16F), luminance_size, luminance_size, 0, GL_RED, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glGenFramebuffers(1, &luminance_framebuffer_);
+    glBindFramebuffer(GL_FRAMEBUFFER, luminance_framebuffer_);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, luminance_texture_, 0);
+
+    // start from a mid grey scene, adapted from there
+    float initial = 0.18f;
+    glGenTextures(2, adapted_textures_);
+    glGenFramebuffers(2, adapted_framebuffers_);
+    for (unsigned i = 0; i < 2; ++i) {
+        glBindTexture(GL_TEXTURE_2D, adapted_textures_[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GLint(GL_R32F), 1, 1, 0, GL_RED, GL_FLOAT, &initial);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glBindFramebuffer(GL_FRAMEBUFFER, adapted_framebuffers_[i]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, adapted_textures_[i], 0);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    last_time_ = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void ToneMapEffect::execute(PostProcessChain const& chain, GLuint input, GLuint output, glm::uvec2 const& size) const {
+    if (luminance_texture_ == 0) {
+        createTargets();
+    }
+    double now = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    float seconds = float(now - last_time_);
+    last_time_ = now;
+
+    // log luminance of the downscaled input, averaged by building the mip chain
+    shader_program const& luminance = chain.getProgram(getName() + " luminance");
+    glUseProgram(luminance.handle);
+    glBindFramebuffer(GL_FRAMEBUFFER, luminance_framebuffer_);
+    glViewport(0, 0, luminance_size, luminance_size);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, input);
+    chain.drawQuad();
+    glBindTexture(GL_TEXTURE_2D, luminance_texture_);
+    glGenerateMipmap(GL_TEXTURE_2D);
+
+    // move the adapted luminance of the last frame towards the measured one
+    unsigned previous = current_;
+    current_ = 1 - current_;
+    shader_program const& adaptation = chain.getProgram(getName() + " adaptation");
+    glUseProgram(adaptation.handle);
+    glUniform1f(adaptation.u_locs.at("adaptation_Factor"), 1.0f - std::exp(-seconds * adaptation_rate));
+    glBindFramebuffer(GL_FRAMEBUFFER, adapted_framebuffers_[current_]);
+    glViewport(0, 0, 1, 1);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, adapted_textures_[previous]);
+    chain.drawQuad();
+
+    // scale by the exposure matching the adapted luminance and compress
+    shader_program const& tone_map = chain.getProgram(getName());
+    glUseProgram(tone_map.handle);
+    glUniform1f(tone_map.u_locs.at("exposure_Scale"), std::exp2(exposure_));
+    glBindFramebuffer(GL_FRAMEBUFFER, output);
+    glViewport(0, 0, GLsizei(size.x), GLsizei(size.y));
+    glBindTexture(GL_TEXTURE_2D, adapted_textures_[current_]);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, input);
+    chain.drawQuad();
+}
+
+float ToneMapEffect::getExposure() const {
+    return exposure_;
+}
+void ToneMapEffect::setExposure(float stops) {
+    exposure_ = stops;
+}
+
+///////////////////////////// PostProcessChain ////////////////////////////////
+PostProcessChain::PostProcessChain(std::string const& shader_path, GLenum format)
+    : shader_path_(shader_path)
+    , format_(format)
+    , effects_{}
+    , passes_{}
+    , quad_{}
+    , shaders_(nullptr)
+    , pool_{}
+{
+    // two triangles with position and texture coordinates
+    std::vector<GLfloat> quad = {
+        -1.0f, 1.0f, 0.0f, 1.0f,
+        -1.0f, -1.0f, 0.0f, 0.0f,
+        1.0f, -1.0f, 1.0f, 0.0f,
+        -1.0f, 1.0f, 0.0f, 1.0f,
+        1.0f, -1.0f, 1.0f, 0.0f,
+        1.0f, 1.0f, 1.0f, 1.0f
+    };
+
+    glGenVertexArrays(1, &quad_.vertex_AO);
+    glBindVertexArray(quad_.vertex_AO);
+
+    glGenBuffers(1, &quad_.vertex_BO);
+    glBindBuffer(GL_ARRAY_BUFFER, quad_.vertex_BO);
+    glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(sizeof(float) * quad.size()), quad.data(), GL_STATIC_DRAW);
+
+    // first attribute is position, second texture coordinate
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, GLsizei(4 * sizeof(float)), nullptr);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, GLsizei(4 * sizeof(float)), (void*)(2 * sizeof(float)));
+
+    quad_.draw_mode = GL_TRIANGLES;
+    quad_.num_elements = GLsizei(quad.size() / 4);
+}
+
+PostProcessChain::~PostProcessChain() {
+    glDeleteBuffers(1, &quad_.vertex_BO);
+    glDeleteVertexArrays(1, &quad_.vertex_AO);
+}
+
+void PostProcessChain::addEffect(std::shared_ptr<PostEffect> const& effect) {
+    effects_.push_back(effect);
+}
+
+std::shared_ptr<PostEffect> PostProcessChain::getEffect(std::string const& name) const {
+    for (auto const& effect : effects_) {
+        if (effect->getName() == name) {
+            return effect;
+        }
+    }
+    return nullptr;
+}
+
+std::vector<std::string> PostProcessChain::build(std::map<std::string, shader_program>& shaders) {
+    passes_.clear();
+    for (auto const& effect : effects_) {
+        if (!effect->getEnabled()) {
+            continue;
+        }
+        if (effect->isFusible()) {
+            // append to previous merged pass if there is one
+            if (passes_.empty() || passes_.back().effect) {
+                passes_.push_back(pass{});
+            }
+            passes_.back().fused.push_back(effect);
+        }
+        else {
+            passes_.push_back(pass{{}, effect, ""});
+        }
+    }
+    // something has to write the output, even if no effect is enabled
+    if (passes_.empty() || passes_.back().effect) {
+        passes_.push_back(pass{});
+    }
+
+    std::set<std::string> existing{};
+    for (auto const& pair : shaders) {
+        existing.insert(pair.first);
+    }
+
+    // plain copy, scales a partially covered input up before the first pass effect
+    if (shaders.find("screen_quad") == shaders.end()) {
+        shaders.emplace("screen_quad", shader_program{{{GL_VERTEX_SHADER, shader_path_ + "screen_quad.vert"},
+                                                       {GL_FRAGMENT_SHADER, shader_path_ + "screen_quad.frag"}}});
+        shaders.at("screen_quad").u_locs["screen_Texture"] = -1;
+        shaders.at("screen_quad").u_locs["texture_Scale"] = -1;
+    }
+
+    for (auto& current : passes_) {
+        if (current.effect) {
+            current.effect->addPrograms(shaders, shader_path_);
+            continue;
+        }
+        // every combination of merged effects is its own variant
+        std::vector<std::string> defines{};
+        std::string name{"screen_quad"};
+        for (auto const& effect : current.fused) {
+            defines.push_back(effect->getDefine());
+            name += " " + effect->getDefine();
+        }
+        current.program = name;
+
+        if (shaders.find(name) == shaders.end()) {
+            shaders.emplace(name, shader_program{{{GL_VERTEX_SHADER, shader_path_ + "screen_quad.vert"},
+                                                  {GL_FRAGMENT_SHADER, shader_path_ + "screen_quad.frag"}},
+                                                 defines});
+            shaders.at(name).u_locs["screen_Texture"] = -1;
+            shaders.at(name).u_locs["texture_Scale"] = -1;
+            for (auto const& effect : current.fused) {
+                effect->addUniforms(shaders.at(name));
+            }
+        }
+    }
+
+    std::vector<std::string> added{};
+    for (auto const& pair : shaders) {
+        if (existing.find(pair.first) == existing.end()) {
+            added.push_back(pair.first);
+        }
+    }
+    return added;
+}
+
+void PostProcessChain::uploadUniforms(std::map<std::string, shader_program> const& shaders, glm::uvec2 const& size) const {
+    for (auto const& current : passes_) {
+        if (current.effect) {
+            current.effect->uploadProgramUniforms(shaders, size);
+        }
+        else {
+            shader_program const& program = shaders.at(current.program);
+            glUseProgram(program.handle);
+            glUniform1i(program.u_locs.at("screen_Texture"), 0);
+        }
+    }
+}
+
+void PostProcessChain::render(std::map<std::string, shader_program> const& shaders, GLuint input, GLuint output, glm::uvec2 const& size,
+                              glm::fvec2 const& input_scale) const {
+    shaders_ = &shaders;
+    glDisable(GL_DEPTH_TEST);
+    glViewport(0, 0, GLsizei(size.x), GLsizei(size.y));
+
+    GLuint input_texture = input;
+    render_target* previous = nullptr;
+    glm::fvec2 scale = input_scale;
+    // pass effects read their whole input, so a partially covered one is stretched into a full target first
+    if (scale != glm::fvec2{1.0f} && !passes_.empty() && passes_.front().effect) {
+        shader_program const& copy = shaders.at("screen_quad");
+        previous = acquireTarget(size);
+        glBindFramebuffer(GL_FRAMEBUFFER, previous->framebuffer.handle);
+        glUseProgram(copy.handle);
+        glUniform2f(copy.u_locs.at("texture_Scale"), scale.x, scale.y);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, input_texture);
+        drawQuad();
+        input_texture = previous->framebuffer.color_handle;
+        scale = glm::fvec2{1.0f};
+    }
+    for (std::size_t i = 0; i < passes_.size(); ++i) {
+        pass const& current = passes_[i];
+        // last pass writes directly into the output
+        render_target* target = (i + 1 < passes_.size()) ? acquireTarget(size) : nullptr;
+        GLuint framebuffer = target ? target->framebuffer.handle : output;
+
+        if (current.effect) {
+            current.effect->execute(*this, input_texture, framebuffer, size);
+        }
+        else {
+            shader_program const& program = shaders.at(current.program);
+            glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+            glUseProgram(program.handle);
+            // only the first pass reads the partially covered input
+            glUniform2f(program.u_locs.at("texture_Scale"), scale.x, scale.y);
+            for (auto const& effect : current.fused) {
+                effect->uploadUniforms(program);
+            }
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, input_texture);
+            drawQuad();
+        }
+
+        // output of the previous pass has been read, its target can be reused
+        if (previous) {
+            releaseTarget(previous);
+        }
+        previous = target;
+        input_texture = target ? target->framebuffer.color_handle : 0;
+        scale = glm::fvec2{1.0f};
+    }
+    shaders_ = nullptr;
+}
+
+shader_program const& PostProcessChain::getProgram(std::string const& name) const {
+    return shaders_->at(name);
+}
+
+render_target* PostProcessChain::acquireTarget(glm::uvec2 const& size) const {
+    return pool_.acquire(size, format_);
+}
+
+render_target* PostProcessChain::acquireTarget(glm::uvec2 const& size, GLenum format) const {
+    return pool_.acquire(size, format);
+}
+
+void PostProcessChain::releaseTarget(render_target* target) const {
+    pool_.release(target);
+}
+
+void PostProcessChain::drawQuad() const {
+    glBindVertexArray(quad_.vertex_AO);
+    glDrawArrays(quad_.draw_mode, 0, quad_.num_elements);
+}
+
+void PostProcessChain::trimTargets() {
+    pool_.trim();
+}
+
+GLenum PostProcessChain::getFormat() const {
+    return format_;
+}
+void PostProcessChain::setFormat(GLenum format) {
+    // intermediates of the old format are never acquired again
+    format_ = format;
+    pool_.trim();
+}
+
+std::size_t PostProcessChain::getPassCount() const {
+    return passes_.size();
+}
+
+RenderTargetPool const& PostProcessChain::getPool() const {
+    return pool_;
+}
@@ -0,0 +1,161 @@
+#include "render_queue.hpp"
+
+#include <glbinding/gl/gl.h>
+// use gl definitions from glbinding
+using namespace gl;
+
+#include <algorithm>
+#include <cstring>
+
+// handle value never returned by gl, marks unknown state
+static const GLuint unknown_handle = ~GLuint(0);
+
+///////////////////////////// StateCache //////////////////////////////////////
+StateCache::StateCache()
+    : program_{unknown_handle}
+    , vertex_array_{unknown_handle}
+    , active_unit_{unknown_handle}
+    , textures_{}
+    , issued_{0}
+    , skipped_{0}
+{
+    invalidate();
+}
+
+bool StateCache::change(GLuint& current, GLuint value) {
+    if (current == value) {
+        ++skipped_;
+        return false;
+    }
+    current = value;
+    ++issued_;
+    return true;
+}
+
+void StateCache::useProgram(GLuint program) {
+    if (change(program_, program)) {
+        glUseProgram(program);
+    }
+}
+
+void StateCache::bindVertexArray(GLuint vertex_array) {
+    if (change(vertex_array_, vertex_array)) {
+        glBindVertexArray(vertex_array);
+    }
+}
+
+void StateCache::bindTexture(GLuint unit, GLenum target, GLuint texture) {
+    if (unit >= tracked_units) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(target, texture);
+        active_unit_ = unit;
+        issued_ += 2;
+        return;
+    }
+    texture_binding& binding = textures_[unit];
+    // one target is tracked per unit, switching the target of a unit is always issued
+    if (binding.target == target && binding.handle == texture) {
+        ++skipped_;
+        return;
+    }
+    if (change(active_unit_, unit)) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+    }
+    glBindTexture(target, texture);
+    binding.target = target;
+    binding.handle = texture;
+    ++issued_;
+}
+
+void StateCache::invalidate() {
+    program_ = unknown_handle;
+    vertex_array_ = unknown_handle;
+    active_unit_ = unknown_handle;
+    for (texture_binding& binding : textures_) {
+        binding.target = GL_NONE;
+        binding.handle = unknown_handle;
+    }
+}
+
+std::size_t StateCache::getIssuedCount() const {
+    return issued_;
+}
+std::size_t StateCache::getSkippedCount() const {
+    return skipped_;
+}
+void StateCache::resetCounters() {
+    issued_ = 0;
+    skipped_ = 0;
+}
+
+///////////////////////////// RenderQueue /////////////////////////////////////
+RenderQueue::RenderQueue()
+    : passes_{}
+    , depth_sorted_layers_{0}
+    , commands_{}
+{}
+
+std::size_t RenderQueue::addPass(draw_function const& draw) {
+    passes_.push_back(draw);
+    return passes_.size() - 1;
+}
+
+void RenderQueue::setDepthSorted(unsigned layer, bool sorted) {
+    std::uint32_t bit = std::uint32_t(1) << (layer & 0xfu);
+    depth_sorted_layers_ = sorted ? depth_sorted_layers_ | bit : depth_sorted_layers_ & ~bit;
+}
+
+std::uint64_t RenderQueue::makeKey(unsigned layer, GLuint program, GLuint vertex_array, GLuint texture, float depth,
+                                   bool depth_first) {
+    // bit pattern of a non-negative float grows with its value
+    std::uint32_t depth_bits = 0;
+    float distance = std::max(depth, 0.0f);
+    std::memcpy(&depth_bits, &distance, sizeof(depth_bits));
+
+    // handles are truncated, colliding ones only cost a redundant bind
+    if (depth_first) {
+        return (std::uint64_t(layer & 0xfu) << 60)
+             | (std::uint64_t(depth_bits >> 11) << 40)
+             | (std::uint64_t(program & 0xfffu) << 28)
+             | (std::uint64_t(vertex_array & 0xfffu) << 16)
+             | std::uint64_t(texture & 0xffffu);
+    }
+    return (std::uint64_t(layer & 0xfu) << 60)
+         | (std::uint64_t(program & 0xfffu) << 48)
+         | (std::uint64_t(vertex_array & 0xfffu) << 36)
+         | (std::uint64_t(texture & 0xffffu) << 20)
+         | std::uint64_t(depth_bits >> 11);
+}
+
+void RenderQueue::submit(unsigned layer, GLuint program, GLuint vertex_array, GLenum texture_target, GLuint texture,
+                         float depth, std::size_t pass, std::size_t argument) {
+    render_command command{};
+    bool depth_first = (depth_sorted_layers_ >> (layer & 0xfu) & 1u) != 0;
+    command.key = makeKey(layer, program, vertex_array, texture, depth, depth_first);
+    command.program = program;
+    command.vertex_array = vertex_array;
+    command.texture_target = texture_target;
+    command.texture = texture;
+    command.pass = pass;
+    command.argument = argument;
+    commands_.push_back(command);
+}
+
+void RenderQueue::execute(StateCache& state) {
+    std::sort(commands_.begin(), commands_.end(), [](render_command const& a, render_command const& b) {
+        return a.key < b.key;
+    });
+    for (render_command const& command : commands_) {
+        state.useProgram(command.program);
+        state.bindVertexArray(command.vertex_array);
+        if (command.texture_target != GL_NONE) {
+            state.bindTexture(0, command.texture_target, command.texture);
+        }
+        passes_[command.pass](command.argument);
+    }
+    commands_.clear();
+}
+
+std::size_t RenderQueue::getCommandCount() const {
+    return commands_.size();
+}
@@ -0,0 +1,248 @@
+#include "render_target_pool.hpp"
+
+#include <glbinding/gl/gl.h>
+// use gl definitions from glbinding
+using namespace gl;
+
+#include <algorithm>
+#include <iostream>
+
+// client format matching a sized internal format, required even without data
+static void transfer_format(GLenum internal_format, GLenum& format, GLenum& type) {
+    switch (internal_format) {
+        case GL_RGBA8:
+            format = GL_RGBA;
+            type = GL_UNSIGNED_BYTE;
+            break;
+        case GL_RGBA16F:
+        case GL_RGBA32F:
+            format = GL_RGBA;
+            type = GL_FLOAT;
+            break;
+        case GL_R11F_G11F_B10F:
+        case GL_RGB16F:
+        case GL_RGB32F:
+            format = GL_RGB;
+            type = GL_FLOAT;
+            break;
+        case GL_R16F:
+        case GL_R32F:
+            format = GL_RED;
+            type = GL_FLOAT;
+            break;
+        case GL_DEPTH_COMPONENT16:
+        case GL_DEPTH_COMPONENT24:
+            format = GL_DEPTH_COMPONENT;
+            type = GL_UNSIGNED_INT;
+            break;
+        case GL_DEPTH_COMPONENT32F:
+            format = GL_DEPTH_COMPONENT;
+            type = GL_FLOAT;
+            break;
+        default:
+            format = GL_RGB;
+            type = GL_UNSIGNED_BYTE;
+    }
+}
+
+// storage of a single pixel of a sized internal format
+static std::size_t pixel_bytes(GLenum internal_format) {
+    switch (internal_format) {
+        case GL_NONE:
+            return 0;
+        case GL_R16F:
+        case GL_DEPTH_COMPONENT16:
+            return 2;
+        case GL_RGB8:
+        case GL_DEPTH_COMPONENT24:
+            // drivers pad to 4 bytes
+            return 4;
+        case GL_RGBA16F:
+            return 8;
+        case GL_RGB16F:
+            return 6;
+        case GL_RGB32F:
+            return 12;
+        case GL_RGBA32F:
+            return 16;
+        default:
+            // RGBA8, R11F_G11F_B10F, R32F, DEPTH_COMPONENT32F
+            return 4;
+    }
+}
+
+// texture of the target size without data
+static GLuint create_texture(render_target const& target, GLenum internal_format, GLenum filter) {
+    GLenum format = GL_NONE;
+    GLenum type = GL_NONE;
+    transfer_format(internal_format, format, type);
+
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    // multisample textures have no filtering, they are only read by resolving
+    if (target.samples > 1) {
+        glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, texture);
+        glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, target.samples, internal_format,
+                                GLsizei(target.size.x), GLsizei(target.size.y), GL_TRUE);
+        glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, 0);
+        return texture;
+    }
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GLint(internal_format), GLsizei(target.size.x), GLsizei(target.size.y), 0, format, type, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return texture;
+}
+
+static void create_target(render_target& target) {
+    GLenum texture_target = target.samples > 1 ? GL_TEXTURE_2D_MULTISAMPLE : GL_TEXTURE_2D;
+    glGenFramebuffers(1, &target.framebuffer.handle);
+    glBindFramebuffer(GL_FRAMEBUFFER, target.framebuffer.handle);
+
+    std::vector<GLenum> draw_buffers{};
+    for (std::size_t i = 0; i < target.formats.size(); ++i) {
+        // passes sample between texels, e.g. linear blur taps
+        GLuint texture = create_texture(target, target.formats[i], GL_LINEAR);
+        GLenum attachment = GL_COLOR_ATTACHMENT0 + GLuint(i);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, texture_target, texture, 0);
+        target.framebuffer.color_handles.push_back(texture);
+        draw_buffers.push_back(attachment);
+    }
+    // outputs of a fragment shader are written to the attachment of the same location
+    glDrawBuffers(GLsizei(draw_buffers.size()), draw_buffers.data());
+    target.framebuffer.color_buffer.target = texture_target;
+    target.framebuffer.color_buffer.handle = target.framebuffer.color_handles.front();
+    target.framebuffer.color_handle = target.framebuffer.color_handles.front();
+
+    // post processing passes need no depth
+    target.framebuffer.depth_handle = 0;
+    if (target.depth_format != GL_NONE) {
+        // depth is read back exactly, e.g. to reconstruct positions
+        target.framebuffer.depth_handle = create_texture(target, target.depth_format, GL_NEAREST);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, texture_target, target.framebuffer.depth_handle, 0);
+    }
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "RenderTargetPool: framebuffer incomplete" << std::endl;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+static void delete_target(render_target& target) {
+    glDeleteFramebuffers(1, &target.framebuffer.handle);
+    glDeleteTextures(GLsizei(target.framebuffer.color_handles.size()), target.framebuffer.color_handles.data());
+    if (target.framebuffer.depth_handle != 0) {
+        glDeleteTextures(1, &target.framebuffer.depth_handle);
+    }
+    target.framebuffer = framebuffer_object{};
+}
+
+RenderTargetPool::RenderTargetPool()
+        : targets_{}
+{}
+
+RenderTargetPool::~RenderTargetPool() {
+    clear();
+}
+
+// compares without building a format list, single target acquires happen every frame
+static bool matches(render_target const& target, glm::uvec2 const& size, GLenum const* formats, std::size_t count,
+                    GLenum depth_format, GLsizei samples) {
+    return target.size == size && target.depth_format == depth_format && target.samples == samples
+        && target.formats.size() == count && std::equal(formats, formats + count, target.formats.begin());
+}
+
+render_target* RenderTargetPool::acquire(glm::uvec2 const& size, GLenum format, GLenum depth_format, GLsizei samples) {
+    for (auto const& target : targets_) {
+        if (!target->in_use && matches(*target, size, &format, 1, depth_format, samples)) {
+            target->in_use = true;
+            return target.get();
+        }
+    }
+    return acquire(size, std::vector<GLenum>{format}, depth_format, samples);
+}
+
+render_target* RenderTargetPool::acquire(glm::uvec2 const& size, std::vector<GLenum> const& formats, GLenum depth_format,
+                                         GLsizei samples) {
+    for (auto const& target : targets_) {
+        if (!target->in_use && matches(*target, size, formats.data(), formats.size(), depth_format, samples)) {
+            target->in_use = true;
+            return target.get();
+        }
+    }
+
+    targets_.emplace_back(new render_target{framebuffer_object{}, size, formats, depth_format, samples, true});
+    create_target(*targets_.back());
+    return targets_.back().get();
+}
+
+void RenderTargetPool::release(render_target* target) {
+    target->in_use = false;
+}
+
+bool RenderTargetPool::resize(render_target* target, glm::uvec2 const& size, GLenum format, GLenum depth_format,
+                              GLsizei samples) {
+    if (matches(*target, size, &format, 1, depth_format, samples)) {
+        return false;
+    }
+    return resize(target, size, std::vector<GLenum>{format}, depth_format, samples);
+}
+
+bool RenderTargetPool::resize(render_target* target, glm::uvec2 const& size, std::vector<GLenum> const& formats,
+                              GLenum depth_format, GLsizei samples) {
+    if (matches(*target, size, formats.data(), formats.size(), depth_format, samples)) {
+        return false;
+    }
+    // old attachments are freed before the new ones are allocated
+    delete_target(*target);
+    target->size = size;
+    target->formats = formats;
+    target->depth_format = depth_format;
+    target->samples = samples;
+    create_target(*target);
+    return true;
+}
+
+void RenderTargetPool::trim() {
+    auto unused = std::partition(targets_.begin(), targets_.end(),
+                                 [](std::unique_ptr<render_target> const& target) { return target->in_use; });
+    for (auto target = unused; target != targets_.end(); ++target) {
+        delete_target(**target);
+    }
+    targets_.erase(unused, targets_.end());
+}
+
+void RenderTargetPool::clear() {
+    for (auto const& target : targets_) {
+        delete_target(*target);
+    }
+    targets_.clear();
+}
+
+std::size_t RenderTargetPool::getTargetCount() const {
+    return targets_.size();
+}
+
+std::size_t RenderTargetPool::getMemoryUsage() const {
+    std::size_t bytes = 0;
+    for (auto const& target : targets_) {
+        // every sample is stored
+        std::size_t pixels = std::size_t(target->size.x) * std::size_t(target->size.y) * std::size_t(target->samples);
+        bytes += pixels * pixel_bytes(target->depth_format);
+        for (GLenum format : target->formats) {
+            bytes += pixels * pixel_bytes(format);
+        }
+    }
+    return bytes;
+}
+
+GLsizei RenderTargetPool::getMaxSamples() {
+    GLint color = 1;
+    GLint depth = 1;
+    glGetIntegerv(GL_MAX_COLOR_TEXTURE_SAMPLES, &color);
+    glGetIntegerv(GL_MAX_DEPTH_TEXTURE_SAMPLES, &depth);
+    return GLsizei(std::min(color, depth));
+}
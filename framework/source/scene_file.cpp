@@ -0,0 +1,394 @@
+#include "scene_file.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <set>
+#include <stdexcept>
+
+// first bytes of a binary scene, followed by the format version
+static const char binary_magic[4] = {'S', 'C', 'N', 'B'};
+static const std::uint32_t binary_version = 1;
+
+body_description::body_description()
+ :name{}
+ ,parent{}
+ ,size{1.0f}
+ ,speed{0.0f}
+ ,distance{0.0f}
+ ,color{1.0f}
+ ,texture{}
+ ,eccentricity{0.0f}
+ ,inclination{0.0f}
+ ,ascending_node{0.0f}
+ ,periapsis{0.0f}
+ ,light{false}
+ ,light_intensity{1.0f}
+ ,light_color{255.0f}
+{}
+
+///////////////////////////// json reading ////////////////////////////////////
+// reads values in place, objects and arrays are handed to callbacks element by element
+// covers the json subset used by scene files, no unicode escapes
+class JsonReader {
+public:
+    JsonReader(std::string const& text)
+     :text_(text)
+     ,position_{0}
+    {}
+
+    template<typename Callback>
+    void readObject(Callback on_member) {
+        expect('{');
+        if (consume('}')) {
+            return;
+        }
+        do {
+            std::string key = readString();
+            expect(':');
+            on_member(key);
+        } while (consume(','));
+        expect('}');
+    }
+
+    template<typename Callback>
+    void readArray(Callback on_element) {
+        expect('[');
+        if (consume(']')) {
+            return;
+        }
+        do {
+            on_element();
+        } while (consume(','));
+        expect(']');
+    }
+
+    std::string readString() {
+        expect('"');
+        std::string value{};
+        while (position_ < text_.size() && text_[position_] != '"') {
+            char c = text_[position_++];
+            if (c == '\\' && position_ < text_.size()) {
+                char escaped = text_[position_++];
+                switch (escaped) {
+                    case 'n': c = '\n'; break;
+                    case 't': c = '\t'; break;
+                    case 'r': c = '\r'; break;
+                    case 'b': c = '\b'; break;
+                    case 'f': c = '\f'; break;
+                    case 'u': fail("unicode escapes are not supported"); break;
+                    default: c = escaped; break;
+                }
+            }
+            value += c;
+        }
+        expect('"');
+        return value;
+    }
+
+    float readNumber() {
+        skipWhitespace();
+        char const* begin = text_.c_str() + position_;
+        char* end = nullptr;
+        double value = std::strtod(begin, &end);
+        if (end == begin) {
+            fail("expected number");
+        }
+        position_ += std::size_t(end - begin);
+        return float(value);
+    }
+
+    bool readBool() {
+        skipWhitespace();
+        if (text_.compare(position_, 4, "true") == 0) {
+            position_ += 4;
+            return true;
+        }
+        if (text_.compare(position_, 5, "false") == 0) {
+            position_ += 5;
+            return false;
+        }
+        fail("expected boolean");
+        return false;
+    }
+
+    glm::fvec3 readVector() {
+        glm::fvec3 value{0.0f};
+        int component = 0;
+        readArray([&] {
+            float number = readNumber();
+            if (component > 2) {
+                fail("expected three components");
+            }
+            value[component++] = number;
+        });
+        if (component != 3) {
+            fail("expected three components");
+        }
+        return value;
+    }
+
+    // values of unknown keys
+    void skipValue() {
+        skipWhitespace();
+        char c = peek();
+        if (c == '{') {
+            readObject([this](std::string const&) { skipValue(); });
+        }
+        else if (c == '[') {
+            readArray([this] { skipValue(); });
+        }
+        else if (c == '"') {
+            readString();
+        }
+        else if (c == 't' || c == 'f') {
+            readBool();
+        }
+        else if (text_.compare(position_, 4, "null") == 0) {
+            position_ += 4;
+        }
+        else {
+            readNumber();
+        }
+    }
+
+    void finish() {
+        skipWhitespace();
+        if (position_ != text_.size()) {
+            fail("unexpected content after scene");
+        }
+    }
+
+    void fail(std::string const& message) const {
+        throw std::logic_error("scene file: " + message + " at offset " + std::to_string(position_));
+    }
+
+private:
+    void skipWhitespace() {
+        while (position_ < text_.size()) {
+            char c = text_[position_];
+            if (c != ' ' && c != '\t' && c != '\r' && c != '\n') {
+                break;
+            }
+            ++position_;
+        }
+    }
+    char peek() {
+        skipWhitespace();
+        return position_ < text_.size() ? text_[position_] : '\0';
+    }
+    bool consume(char c) {
+        if (peek() == c) {
+            ++position_;
+            return true;
+        }
+        return false;
+    }
+    void expect(char c) {
+        if (!consume(c)) {
+            fail(std::string{"expected '"} + c + "'");
+        }
+    }
+
+    std::string const& text_;
+    std::size_t position_;
+};
+
+static body_description read_body(JsonReader& reader) {
+    body_description body{};
+    reader.readObject([&](std::string const& key) {
+        if (key == "name") body.name = reader.readString();
+        else if (key == "parent") body.parent = reader.readString();
+        else if (key == "size") body.size = reader.readNumber();
+        else if (key == "speed") body.speed = reader.readNumber();
+        else if (key == "distance") body.distance = reader.readNumber();
+        else if (key == "color") body.color = reader.readVector();
+        else if (key == "texture") body.texture = reader.readString();
+        else if (key == "eccentricity") body.eccentricity = reader.readNumber();
+        else if (key == "inclination") body.inclination = reader.readNumber();
+        else if (key == "ascending_node") body.ascending_node = reader.readNumber();
+        else if (key == "periapsis") body.periapsis = reader.readNumber();
+        else if (key == "light") {
+            body.light = true;
+            reader.readObject([&](std::string const& light_key) {
+                if (light_key == "intensity") body.light_intensity = reader.readNumber();
+                else if (light_key == "color") body.light_color = reader.readVector();
+                else reader.skipValue();
+            });
+        }
+        else reader.skipValue();
+    });
+    if (body.name.empty()) {
+        reader.fail("body without name");
+    }
+    return body;
+}
+
+///////////////////////////// binary reading and writing /////////////////////
+template<typename T>
+static void write_value(std::ofstream& file, T const& value) {
+    file.write(reinterpret_cast<char const*>(&value), sizeof(T));
+}
+static void write_string(std::ofstream& file, std::string const& value) {
+    write_value(file, std::uint32_t(value.size()));
+    file.write(value.data(), std::streamsize(value.size()));
+}
+static void write_vector(std::ofstream& file, glm::fvec3 const& value) {
+    write_value(file, value.x);
+    write_value(file, value.y);
+    write_value(file, value.z);
+}
+
+// reads from the file contents, throws instead of reading past the end
+class BinaryReader {
+public:
+    BinaryReader(std::string const& data, std::size_t position)
+     :data_(data)
+     ,position_{position}
+    {}
+
+    template<typename T>
+    T read() {
+        T value;
+        std::memcpy(&value, take(sizeof(T)), sizeof(T));
+        return value;
+    }
+    glm::fvec3 readVector() {
+        float x = read<float>();
+        float y = read<float>();
+        float z = read<float>();
+        return glm::fvec3{x, y, z};
+    }
+    std::string readString() {
+        std::size_t length = read<std::uint32_t>();
+        char const* begin = take(length);
+        return std::string(begin, length);
+    }
+
+private:
+    char const* take(std::size_t bytes) {
+        if (data_.size() - position_ < bytes) {
+            throw std::logic_error("scene file: unexpected end of binary scene");
+        }
+        char const* begin = data_.data() + position_;
+        position_ += bytes;
+        return begin;
+    }
+
+    std::string const& data_;
+    std::size_t position_;
+};
+
+static scene_description parse_binary(std::string const& data) {
+    BinaryReader reader{data, sizeof(binary_magic)};
+    if (reader.read<std::uint32_t>() != binary_version) {
+        throw std::logic_error("scene file: unsupported binary version");
+    }
+    scene_description scene{};
+    scene.name = reader.readString();
+    std::uint32_t count = reader.read<std::uint32_t>();
+    // count is not trusted for the allocation, every body needs at least its fixed fields
+    scene.bodies.reserve(std::min<std::size_t>(count, data.size() / 64));
+    for (std::uint32_t i = 0; i < count; ++i) {
+        body_description body{};
+        body.name = reader.readString();
+        body.parent = reader.readString();
+        body.texture = reader.readString();
+        body.size = reader.read<float>();
+        body.speed = reader.read<float>();
+        body.distance = reader.read<float>();
+        body.color = reader.readVector();
+        body.eccentricity = reader.read<float>();
+        body.inclination = reader.read<float>();
+        body.ascending_node = reader.read<float>();
+        body.periapsis = reader.read<float>();
+        body.light = reader.read<std::uint8_t>() != 0;
+        body.light_intensity = reader.read<float>();
+        body.light_color = reader.readVector();
+        scene.bodies.push_back(body);
+    }
+    return scene;
+}
+
+// parents must be known before their children
+static void validate(scene_description const& scene) {
+    std::set<std::string> names{};
+    for (auto const& body : scene.bodies) {
+        if (!body.parent.empty() && names.count(body.parent) == 0) {
+            throw std::logic_error("scene file: parent " + body.parent + " of " + body.name + " is not defined before");
+        }
+        if (!names.insert(body.name).second) {
+            throw std::logic_error("scene file: body " + body.name + " is defined twice");
+        }
+    }
+}
+
+namespace scene_file {
+
+scene_description load(std::string const& path) {
+    std::ifstream file{path, std::ios::in | std::ios::binary};
+    if (!file) {
+        throw std::logic_error("scene file: cannot open " + path);
+    }
+    std::string data{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+
+    scene_description scene{};
+    if (data.size() >= sizeof(binary_magic) && data.compare(0, sizeof(binary_magic), binary_magic, sizeof(binary_magic)) == 0) {
+        scene = parse_binary(data);
+    }
+    else {
+        scene = parse_json(data);
+    }
+    validate(scene);
+    return scene;
+}
+
+scene_description parse_json(std::string const& text) {
+    scene_description scene{};
+    JsonReader reader{text};
+    reader.readObject([&](std::string const& key) {
+        if (key == "name") {
+            scene.name = reader.readString();
+        }
+        else if (key == "bodies") {
+            reader.readArray([&] { scene.bodies.push_back(read_body(reader)); });
+        }
+        else {
+            reader.skipValue();
+        }
+    });
+    reader.finish();
+    return scene;
+}
+
+void save_binary(scene_description const& scene, std::string const& path) {
+    std::ofstream file{path, std::ios::out | std::ios::binary | std::ios::trunc};
+    if (!file) {
+        throw std::logic_error("scene file: cannot write " + path);
+    }
+    file.write(binary_magic, sizeof(binary_magic));
+    write_value(file, binary_version);
+    write_string(file, scene.name);
+    write_value(file, std::uint32_t(scene.bodies.size()));
+    for (auto const& body : scene.bodies) {
+        write_string(file, body.name);
+        write_string(file, body.parent);
+        write_string(file, body.texture);
+        write_value(file, body.size);
+        write_value(file, body.speed);
+        write_value(file, body.distance);
+        write_vector(file, body.color);
+        write_value(file, body.eccentricity);
+        write_value(file, body.inclination);
+        write_value(file, body.ascending_node);
+        write_value(file, body.periapsis);
+        write_value(file, std::uint8_t(body.light));
+        write_value(file, body.light_intensity);
+        write_vector(file, body.light_color);
+    }
+}
+
+}
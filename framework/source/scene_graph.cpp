@@ -1,21 +1,31 @@
 #include "scene_graph.hpp"
 
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
 // constructors
-SceneGraph::SceneGraph() : name_("DefaultSceneGraph"), rootNode_(std::make_shared<Node>(Node())) {}
-SceneGraph::SceneGraph(std::string const& name) : name_(name), rootNode_(std::make_shared<Node>(Node())){}
-SceneGraph::SceneGraph(std::string const& name, std::shared_ptr<Node> const& rootNode) : name_(name), rootNode_(rootNode){}
+SceneGraph::SceneGraph() : name_("DefaultSceneGraph"), rootNode_(std::make_shared<Node>(Node())) {
+    indexNode(rootNode_);
+}
+SceneGraph::SceneGraph(std::string const& name) : name_(name), rootNode_(std::make_shared<Node>(Node())){
+    indexNode(rootNode_);
+}
+SceneGraph::SceneGraph(std::string const& name, std::shared_ptr<Node> const& rootNode) : name_(name), rootNode_(rootNode){
+    indexNode(rootNode_);
+}
 
 // get attribute methods
-std::string SceneGraph::getName()const{
+std::string const& SceneGraph::getName()const{
     return name_;
 }
 std::shared_ptr<Node> SceneGraph::getRoot()const{
     return rootNode_;
 }
-std::list<std::shared_ptr<GeometryNode>> SceneGraph::getPlanets()const{
+std::list<std::shared_ptr<GeometryNode>> const& SceneGraph::getPlanets()const{
     return planets_;
 }
-std::list<std::shared_ptr<PointLightNode>> SceneGraph::getLightNodes()const{
+std::list<std::shared_ptr<PointLightNode>> const& SceneGraph::getLightNodes()const{
     return lightNodes_;
 }
 
@@ -25,6 +35,81 @@ void SceneGraph::setName(std::string const& name){
 }
 void SceneGraph::setRoot(std::shared_ptr<Node> const& rootNode){
     rootNode_ = rootNode;
+    nodes_.clear();
+    indexNode(rootNode_);
+}
+
+// node lookup by path
+void SceneGraph::addNode(std::shared_ptr<Node> const& parent, std::shared_ptr<Node> const& node){
+    for (std::shared_ptr<Node> ancestor = parent; ancestor; ancestor = ancestor->getParent()) {
+        if (ancestor == node) {
+            throw std::logic_error("scene graph: " + node->getPath() + " can not be added below itself");
+        }
+    }
+    // check the paths the whole subtree will have before anything is changed
+    std::list<std::pair<std::shared_ptr<Node>, std::string>> pending{{node, parent->getPath() + "/" + node->getName()}};
+    while (!pending.empty()) {
+        std::shared_ptr<Node> current = pending.front().first;
+        std::string path = pending.front().second;
+        pending.pop_front();
+        auto found = nodes_.find(path);
+        if (found != nodes_.end() && found->second != current) {
+            throw std::logic_error("scene graph: path " + path + " already exists");
+        }
+        for (auto const& child : current->getChildren()) {
+            pending.push_back({child, path + "/" + child->getName()});
+        }
+    }
+    // a node attached elsewhere is moved, it keeps its planets and lights
+    std::shared_ptr<Node> previous = node->getParent();
+    if (previous) {
+        auto const& siblings = previous->getChildren();
+        if (std::find(siblings.begin(), siblings.end(), node) != siblings.end()) {
+            unindexNode(node);
+            previous->removeChild(node);
+        }
+    }
+    node->setParent(parent);
+    parent->addChild(node);
+    indexNode(node);
+}
+void SceneGraph::removeNode(std::string const& path){
+    auto found = nodes_.find(path);
+    if (found == nodes_.end()) {
+        return;
+    }
+    std::shared_ptr<Node> node = found->second;
+    unindexNode(node);
+    forgetNode(node);
+    if (node->getParent()) {
+        node->getParent()->removeChild(node);
+    }
+}
+std::shared_ptr<Node> SceneGraph::findNode(std::string const& path)const{
+    auto found = nodes_.find(path);
+    return found == nodes_.end() ? nullptr : found->second;
+}
+void SceneGraph::indexNode(std::shared_ptr<Node> const& node){
+    nodes_[node->getPath()] = node;
+    for (auto const& child : node->getChildren()) {
+        indexNode(child);
+    }
+}
+void SceneGraph::unindexNode(std::shared_ptr<Node> const& node){
+    auto found = nodes_.find(node->getPath());
+    if (found != nodes_.end() && found->second == node) {
+        nodes_.erase(found);
+    }
+    for (auto const& child : node->getChildren()) {
+        unindexNode(child);
+    }
+}
+void SceneGraph::forgetNode(std::shared_ptr<Node> const& node){
+    planets_.remove_if([&node](std::shared_ptr<GeometryNode> const& planet) { return planet == node; });
+    lightNodes_.remove_if([&node](std::shared_ptr<PointLightNode> const& light) { return light == node; });
+    for (auto const& child : node->getChildren()) {
+        forgetNode(child);
+    }
 }
 
 // add planet
@@ -45,10 +130,10 @@ std::string SceneGraph::printNode(std::shared_ptr<Node> const& node)const{
     std::string outputString = node->getName()/* + "(" + glm::to_string(node->getWorldTransform()) + ")"*/;
     
     // print every child node
-    std::list<std::shared_ptr<Node>> children = node->getChildren();
+    auto const& children = node->getChildren();
     if (children.size() > 0) {
         outputString.append(" -> (");
-        for (auto child : children){
+        for (auto const& child : children){
             outputString.append(printNode(child) + ", ");
         } 
         // remove last comma
@@ -9,6 +9,7 @@
 // use gl definitions from glbinding 
 using namespace gl;
 
+#include <cstdint>
 #include <iostream>
 #include <sstream>
 #include <fstream>
@@ -20,19 +21,48 @@ static std::string file_name(std::string const& file_path) {
   return file_path.substr(file_path.find_last_of("/\\") + 1);
 }
 
-namespace shader_loader {
+// insert defines after the version directive, which must stay the first statement
+static std::string inject_defines(std::string const& source, std::vector<std::string> const& defines) {
+  if (defines.empty()) {
+    return source;
+  }
+
+  std::size_t insert_pos = 0;
+  unsigned next_line = 1;
+  std::size_t version_pos = source.find("#version");
+  if (version_pos != std::string::npos) {
+    insert_pos = source.find('\n', version_pos);
+    insert_pos = (insert_pos == std::string::npos) ? source.size() : insert_pos + 1;
+    // count lines up to insertion point to keep error messages pointing to the file
+    for (std::size_t i = 0; i < insert_pos; ++i) {
+      if (source[i] == '\n') ++next_line;
+    }
+  }
 
-GLuint shader(std::string const& file_path, GLenum shader_type) {
+  std::string define_block{};
+  for (auto const& define : defines) {
+    define_block += "#define " + define + "\n";
+  }
+  define_block += "#line " + std::to_string(next_line) + "\n";
+
+  return source.substr(0, insert_pos) + define_block + source.substr(insert_pos);
+}
+
+// issue compilation, the status is checked separately to allow parallel compiles
+static GLuint start_compile(std::string const& shader_source, GLenum shader_type) {
   GLuint shader = 0;
   shader = glCreateShader(shader_type);
 
-  std::string shader_source{utils::read_file(file_path)};
   // glshadersource expects array of c-strings
   const char* shader_chars = shader_source.c_str();
   glShaderSource(shader, 1, &shader_chars, 0);
 
   glCompileShader(shader);
+  return shader;
+}
 
+// returns whether compilation was successfull, prints log otherwise
+static bool check_compile(GLuint shader, GLenum shader_type, std::string const& name) {
   // check if compilation was successfull
   GLint success = 0;
   glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
@@ -44,32 +74,227 @@ GLuint shader(std::string const& file_path, GLenum shader_type) {
     std::vector<GLchar> log_buffer(log_size);
     glGetShaderInfoLog(shader, log_size, &log_size, log_buffer.data());
     // output errors
-    std::cerr << "OpenGl error: Compilation of " << glbinding::Meta::getString(shader_type).c_str() << " " << file_name(file_path) << ":\n";
+    std::cerr << "OpenGl error: Compilation of " << glbinding::Meta::getString(shader_type).c_str() << " " << name << ":\n";
     std::cerr << std::string{log_buffer.begin(), log_buffer.end()};
+    return false;
+  }
+  return true;
+}
+
+static GLuint compile_source(std::string const& shader_source, GLenum shader_type, std::string const& name) {
+  GLuint shader = start_compile(shader_source, shader_type);
+  if (!check_compile(shader, shader_type, name)) {
     // free broken shader
     glDeleteShader(shader);
 
-    throw std::logic_error("OpenGL error: compilation of " + file_name(file_path));
+    throw std::logic_error("OpenGL error: compilation of " + name);
   }
 
   return shader;
 }
 
-unsigned program(std::map<GLenum, std::string> const& stages) {
-  unsigned program = glCreateProgram();
+// let the driver compile on its own threads, then completion can be queried
+static bool parallel_compile_supported() {
+  static bool const supported = [](){
+    if (!utils::supports_extension(GLextension::GL_ARB_parallel_shader_compile)) {
+      return false;
+    }
+    // use as many threads as the driver wants
+    glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+    return true;
+  }();
+  return supported;
+}
+
+///////////////////////////// program binary cache ///////////////////////////
+// 64 bit FNV-1a, stable across runs and platforms
+static void hash_append(std::uint64_t& hash, std::string const& data) {
+  for (unsigned char c : data) {
+    hash ^= c;
+    hash *= 1099511628211ull;
+  }
+  // separator so that concatenated inputs do not collide
+  hash ^= 0xff;
+  hash *= 1099511628211ull;
+}
+
+static std::string program_hash(std::map<GLenum, std::string> const& sources, std::vector<std::string> const& defines) {
+  std::uint64_t hash = 14695981039346656037ull;
+  // binaries are only valid for the driver that created them
+  hash_append(hash, reinterpret_cast<char const*>(glGetString(GL_VENDOR)));
+  hash_append(hash, reinterpret_cast<char const*>(glGetString(GL_RENDERER)));
+  hash_append(hash, reinterpret_cast<char const*>(glGetString(GL_VERSION)));
+
+  for (auto const& stage : sources) {
+    hash_append(hash, std::to_string(static_cast<unsigned>(stage.first)));
+    hash_append(hash, stage.second);
+  }
+  for (auto const& define : defines) {
+    hash_append(hash, define);
+  }
+
+  std::ostringstream stream;
+  stream << std::hex << hash;
+  return stream.str();
+}
+
+static bool binary_cache_supported() {
+  static bool const supported = [](){
+    if (!utils::supports_version(4, 1) && !utils::supports_extension(GLextension::GL_ARB_get_program_binary)) {
+      return false;
+    }
+    // some drivers expose the extension without any format
+    GLint num_formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_formats);
+    return num_formats > 0;
+  }();
+  return supported;
+}
+
+static char const cache_magic[4] = {'G', 'L', 'P', 'B'};
+
+// returns 0 if no valid binary is stored
+static GLuint load_binary(std::string const& binary_path) {
+  std::ifstream file(binary_path, std::ios::binary);
+  if (!file) {
+    return 0;
+  }
+
+  char magic[4] = {};
+  std::uint32_t format = 0;
+  std::uint32_t length = 0;
+  file.read(magic, sizeof(magic));
+  file.read(reinterpret_cast<char*>(&format), sizeof(format));
+  file.read(reinterpret_cast<char*>(&length), sizeof(length));
+  if (!file || memcmp(magic, cache_magic, sizeof(magic)) != 0) {
+    return 0;
+  }
+
+  std::vector<char> binary(length);
+  file.read(binary.data(), std::streamsize(length));
+  if (!file) {
+    return 0;
+  }
+
+  GLuint program = glCreateProgram();
+  try {
+    glProgramBinary(program, GLenum(format), binary.data(), GLsizei(length));
+  }
+  catch (std::exception&) {
+    // driver rejected the format, fall back to compiling
+    glDeleteProgram(program);
+    return 0;
+  }
+
+  // binaries are rejected after driver updates
+  GLint success = 0;
+  glGetProgramiv(program, GL_LINK_STATUS, &success);
+  if (success == 0) {
+    glDeleteProgram(program);
+    return 0;
+  }
+  return program;
+}
+
+static void store_binary(GLuint program, std::string const& binary_path) {
+  GLint length = 0;
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0) {
+    return;
+  }
+
+  std::vector<char> binary(static_cast<std::size_t>(length));
+  GLenum format = GL_NONE;
+  glGetProgramBinary(program, length, &length, &format, binary.data());
+
+  std::ofstream file(binary_path, std::ios::binary | std::ios::trunc);
+  if (!file) {
+    std::cerr << "Shader cache: could not write " << binary_path << std::endl;
+    return;
+  }
+  std::uint32_t format_value = static_cast<std::uint32_t>(format);
+  std::uint32_t length_value = static_cast<std::uint32_t>(length);
+  file.write(cache_magic, sizeof(cache_magic));
+  file.write(reinterpret_cast<char const*>(&format_value), sizeof(format_value));
+  file.write(reinterpret_cast<char const*>(&length_value), sizeof(length_value));
+  file.write(binary.data(), std::streamsize(length_value));
+}
+
+namespace shader_loader {
+
+GLuint shader(std::string const& file_path, GLenum shader_type, std::vector<std::string> const& defines) {
+  std::string shader_source{inject_defines(utils::read_file(file_path), defines)};
+  return compile_source(shader_source, shader_type, file_name(file_path));
+}
+
+pending_program begin_program(std::map<GLenum, std::string> const& stages, std::vector<std::string> const& defines, std::string const& cache_path) {
+  // read all sources first, they identify the cached binary
+  std::map<GLenum, std::string> sources{};
+  for (auto const& stage : stages) {
+    sources[stage.first] = inject_defines(utils::read_file(stage.second), defines);
+  }
+
+  pending_program pending{};
+  bool use_cache = !cache_path.empty() && binary_cache_supported();
+  if (use_cache) {
+    pending.binary_path = cache_path + program_hash(sources, defines) + ".bin";
+    pending.handle = load_binary(pending.binary_path);
+    if (pending.handle != 0) {
+      return pending;
+    }
+  }
+
+  parallel_compile_supported();
+
+  pending.handle = glCreateProgram();
+  if (use_cache) {
+    // allow retrieving the binary after linking
+    glProgramParameteri(pending.handle, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, 1);
+  }
 
-  std::vector<GLuint> shaders{};
   // load and compile vert and frag shader
   for (auto const& stage : stages) {
-    GLuint shader_handle = shader(stage.second, stage.first);
-    shaders.push_back(shader_handle);
+    GLuint shader_handle = start_compile(sources.at(stage.first), stage.first);
+    pending.shaders[stage.first] = shader_handle;
+    pending.names[stage.first] = file_name(stage.second);
     // attach the shader to program
-    glAttachShader(program, shader_handle);
+    glAttachShader(pending.handle, shader_handle);
   }
 
-  // link shaders
-  glLinkProgram(program);
+  // link shaders, status is queried in finish_program
+  glLinkProgram(pending.handle);
+
+  return pending;
+}
 
+bool program_ready(pending_program const& pending) {
+  // nothing to wait for if loaded from cache
+  if (pending.shaders.empty() || !parallel_compile_supported()) {
+    return true;
+  }
+  GLint completed = 0;
+  glGetProgramiv(pending.handle, GL_COMPLETION_STATUS_ARB, &completed);
+  return completed != 0;
+}
+
+unsigned finish_program(pending_program& pending) {
+  // cached binaries are already linked
+  if (pending.shaders.empty()) {
+    unsigned program = pending.handle;
+    pending.handle = 0;
+    return program;
+  }
+
+  // report compile errors first, they are more useful than the link log
+  for (auto const& stage : pending.shaders) {
+    if (!check_compile(stage.second, stage.first, pending.names.at(stage.first))) {
+      std::string name = pending.names.at(stage.first);
+      discard_program(pending);
+      throw std::logic_error("OpenGL error: compilation of " + name);
+    }
+  }
+
+  unsigned program = pending.handle;
   // check if linking was successfull
   GLint success = 0;
   glGetProgramiv(program, GL_LINK_STATUS, &success);
@@ -80,11 +305,11 @@ unsigned program(std::map<GLenum, std::string> const& stages) {
     // get log
     std::vector<GLchar> log_buffer(log_size);
     glGetProgramInfoLog(program, log_size, &log_size, log_buffer.data());
-    
+
     // output errors
     std::string names{};
-    for(auto const& stage : stages) {
-      names += file_name(stage.second) + " & ";
+    for(auto const& stage : pending.names) {
+      names += stage.second + " & ";
     }
     names.resize(names.size() - 3);
         // output errors
@@ -92,19 +317,40 @@ unsigned program(std::map<GLenum, std::string> const& stages) {
     std::cerr << std::string{log_buffer.begin(), log_buffer.end()};
 
     // free broken program
-    glDeleteProgram(program);
+    discard_program(pending);
 
     throw std::logic_error("OpenGL error: linking of " + names);
   }
 
-  for (auto shader_handle : shaders) {
+  for (auto const& stage : pending.shaders) {
     // detach shader
-    glDetachShader(program, shader_handle);
+    glDetachShader(program, stage.second);
     // and free it
-    glDeleteShader(shader_handle);
+    glDeleteShader(stage.second);
+  }
+  pending.shaders.clear();
+
+  if (!pending.binary_path.empty()) {
+    store_binary(program, pending.binary_path);
   }
 
+  pending.handle = 0;
   return program;
 }
 
+void discard_program(pending_program& pending) {
+  for (auto const& stage : pending.shaders) {
+    glDeleteShader(stage.second);
+  }
+  pending.shaders.clear();
+  glDeleteProgram(pending.handle);
+  pending.handle = 0;
+}
+
+unsigned program(std::map<GLenum, std::string> const& stages, std::vector<std::string> const& defines, std::string const& cache_path) {
+  pending_program pending = begin_program(stages, defines, cache_path);
+  // blocks until the driver is done
+  return finish_program(pending);
+}
+
 }
@@ -18,7 +18,9 @@
 namespace texture_loader {
 pixel_data file(std::string const& file_name) {
   // match to opengl representation
-  stbi_set_flip_vertically_on_load(true);
+  // the flag is global, set it once so decoding on several threads does not race
+  static bool const flipped = (stbi_set_flip_vertically_on_load(true), true);
+  (void)flipped;
 
   uint8_t* data_ptr;
   int width = 0;
@@ -0,0 +1,70 @@
+#include "texture_stream.hpp"
+
+#include "texture_loader.hpp"
+
+#include <iostream>
+#include <stdexcept>
+
+TextureStream::TextureStream(JobSystem& jobs)
+ :jobs_(jobs)
+ ,decoding_{}
+ ,finished_{}
+ ,pending_{0}
+ ,stopping_{false}
+ ,mutex_{}
+{}
+
+TextureStream::~TextureStream() {
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        stopping_ = true;
+    }
+    // decode catches everything it throws
+    jobs_.wait(decoding_);
+}
+
+void TextureStream::request(std::string const& file_name) {
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        ++pending_;
+    }
+    jobs_.run("decode texture", [this, file_name]() { decode(file_name); }, &decoding_);
+}
+
+bool TextureStream::poll(std::string& file_name, pixel_data& image) {
+    std::lock_guard<std::mutex> lock{mutex_};
+    if (finished_.empty()) {
+        return false;
+    }
+    file_name = std::move(finished_.front().first);
+    image = std::move(finished_.front().second);
+    finished_.pop_front();
+    --pending_;
+    return true;
+}
+
+std::size_t TextureStream::getPendingCount() const {
+    std::lock_guard<std::mutex> lock{mutex_};
+    return pending_;
+}
+
+void TextureStream::decode(std::string const& file_name) {
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        if (stopping_) {
+            return;
+        }
+    }
+
+    // decoding runs without the lock
+    try {
+        pixel_data image = texture_loader::file(file_name);
+        std::lock_guard<std::mutex> lock{mutex_};
+        finished_.emplace_back(file_name, std::move(image));
+    }
+    catch (std::exception& error) {
+        std::cerr << "Texture '" << file_name << "' not loaded: " << error.what() << std::endl;
+        std::lock_guard<std::mutex> lock{mutex_};
+        --pending_;
+    }
+}
@@ -0,0 +1,147 @@
+#include "transform_batch.hpp"
+
+#include "simd.hpp"
+
+#include <glm/gtc/matrix_inverse.hpp>
+
+#if defined(__AVX__) || defined(SIMD_SSE2)
+#define TRANSFORM_BATCH_SSE
+#endif
+
+#ifdef TRANSFORM_BATCH_SSE
+
+// glm matrices are 16 consecutive floats in column major order
+static inline float const* data(glm::fmat4 const& matrix) {
+    return &matrix[0][0];
+}
+static inline float* data(glm::fmat4& matrix) {
+    return &matrix[0][0];
+}
+
+#ifdef __AVX__
+static inline __m256 combine(__m256 p0, __m256 p1, __m256 p2, __m256 p3, __m256 l) {
+    __m256 r = _mm256_mul_ps(p0, _mm256_shuffle_ps(l, l, _MM_SHUFFLE(0, 0, 0, 0)));
+    r = _mm256_add_ps(r, _mm256_mul_ps(p1, _mm256_shuffle_ps(l, l, _MM_SHUFFLE(1, 1, 1, 1))));
+    r = _mm256_add_ps(r, _mm256_mul_ps(p2, _mm256_shuffle_ps(l, l, _MM_SHUFFLE(2, 2, 2, 2))));
+    return _mm256_add_ps(r, _mm256_mul_ps(p3, _mm256_shuffle_ps(l, l, _MM_SHUFFLE(3, 3, 3, 3))));
+}
+
+// two result columns per instruction, both halves combine the same parent columns
+// everything is loaded before the first store, so the result may alias the inputs
+static inline void multiply_matrix(float const* parent, float const* local, float* result) {
+    __m256 p0 = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(parent));
+    __m256 p1 = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(parent + 4));
+    __m256 p2 = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(parent + 8));
+    __m256 p3 = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(parent + 12));
+    __m256 l01 = _mm256_loadu_ps(local);
+    __m256 l23 = _mm256_loadu_ps(local + 8);
+    _mm256_storeu_ps(result, combine(p0, p1, p2, p3, l01));
+    _mm256_storeu_ps(result + 8, combine(p0, p1, p2, p3, l23));
+}
+#else
+static inline __m128 combine(__m128 p0, __m128 p1, __m128 p2, __m128 p3, __m128 l) {
+    __m128 r = _mm_mul_ps(p0, _mm_shuffle_ps(l, l, _MM_SHUFFLE(0, 0, 0, 0)));
+    r = _mm_add_ps(r, _mm_mul_ps(p1, _mm_shuffle_ps(l, l, _MM_SHUFFLE(1, 1, 1, 1))));
+    r = _mm_add_ps(r, _mm_mul_ps(p2, _mm_shuffle_ps(l, l, _MM_SHUFFLE(2, 2, 2, 2))));
+    return _mm_add_ps(r, _mm_mul_ps(p3, _mm_shuffle_ps(l, l, _MM_SHUFFLE(3, 3, 3, 3))));
+}
+
+// each result column is a combination of the parent columns
+// everything is loaded before the first store, so the result may alias the inputs
+static inline void multiply_matrix(float const* parent, float const* local, float* result) {
+    __m128 p0 = _mm_loadu_ps(parent);
+    __m128 p1 = _mm_loadu_ps(parent + 4);
+    __m128 p2 = _mm_loadu_ps(parent + 8);
+    __m128 p3 = _mm_loadu_ps(parent + 12);
+    __m128 l0 = _mm_loadu_ps(local);
+    __m128 l1 = _mm_loadu_ps(local + 4);
+    __m128 l2 = _mm_loadu_ps(local + 8);
+    __m128 l3 = _mm_loadu_ps(local + 12);
+    _mm_storeu_ps(result, combine(p0, p1, p2, p3, l0));
+    _mm_storeu_ps(result + 4, combine(p0, p1, p2, p3, l1));
+    _mm_storeu_ps(result + 8, combine(p0, p1, p2, p3, l2));
+    _mm_storeu_ps(result + 12, combine(p0, p1, p2, p3, l3));
+}
+#endif
+
+// a.yzx * b.zxy - a.zxy * b.yzx, w stays zero for columns with zero w
+static inline __m128 cross(__m128 a, __m128 b) {
+    __m128 a_yzx = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+    __m128 b_yzx = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+    __m128 c = _mm_sub_ps(_mm_mul_ps(a, b_yzx), _mm_mul_ps(a_yzx, b));
+    return _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+}
+
+static inline float dot3(__m128 a, __m128 b) {
+    __m128 p = _mm_mul_ps(a, b);
+    float values[4];
+    _mm_storeu_ps(values, p);
+    return values[0] + values[1] + values[2];
+}
+
+// columns of the inverse transpose are the cross products of the other two columns over the determinant
+static inline void normal_matrix(float const* matrix, float* result) {
+    // drop w of the basis vectors
+    __m128 mask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+    __m128 a0 = _mm_and_ps(_mm_loadu_ps(matrix), mask);
+    __m128 a1 = _mm_and_ps(_mm_loadu_ps(matrix + 4), mask);
+    __m128 a2 = _mm_and_ps(_mm_loadu_ps(matrix + 8), mask);
+
+    __m128 c0 = cross(a1, a2);
+    __m128 c1 = cross(a2, a0);
+    __m128 c2 = cross(a0, a1);
+    __m128 inverse_determinant = _mm_set1_ps(1.0f / dot3(a0, c0));
+
+    _mm_storeu_ps(result, _mm_mul_ps(c0, inverse_determinant));
+    _mm_storeu_ps(result + 4, _mm_mul_ps(c1, inverse_determinant));
+    _mm_storeu_ps(result + 8, _mm_mul_ps(c2, inverse_determinant));
+    _mm_storeu_ps(result + 12, _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f));
+}
+
+#endif
+
+namespace transform_batch {
+
+void multiply(glm::fmat4 const* parents, glm::fmat4 const* locals, glm::fmat4* results, std::size_t count) {
+#ifdef TRANSFORM_BATCH_SSE
+    for (std::size_t i = 0; i < count; ++i) {
+        multiply_matrix(data(parents[i]), data(locals[i]), data(results[i]));
+    }
+#else
+    multiply_reference(parents, locals, results, count);
+#endif
+}
+
+void multiply_reference(glm::fmat4 const* parents, glm::fmat4 const* locals, glm::fmat4* results, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+        results[i] = parents[i] * locals[i];
+    }
+}
+
+void normal_matrices(glm::fmat4 const& view, glm::fmat4 const* models, glm::fmat4* results, std::size_t count) {
+#ifdef TRANSFORM_BATCH_SSE
+    for (std::size_t i = 0; i < count; ++i) {
+        glm::fmat4 model_view{};
+        multiply_matrix(data(view), data(models[i]), data(model_view));
+        normal_matrix(data(model_view), data(results[i]));
+    }
+#else
+    normal_matrices_reference(view, models, results, count);
+#endif
+}
+
+void normal_matrices_reference(glm::fmat4 const& view, glm::fmat4 const* models, glm::fmat4* results, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+        results[i] = glm::fmat4{glm::inverseTranspose(glm::fmat3{view * models[i]})};
+    }
+}
+
+char const* instruction_set() {
+#ifdef TRANSFORM_BATCH_SSE
+    return simd::instruction_set();
+#else
+    return "scalar";
+#endif
+}
+
+}
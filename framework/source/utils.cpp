@@ -4,6 +4,9 @@
 #include "structs.hpp"
 
 #include <glbinding/gl/functions.h>
+// load context info extension
+#include <glbinding/ContextInfo.h>
+#include <glbinding/Version.h>
 // use gl definitions from glbinding 
 using namespace gl;
 
@@ -13,6 +16,14 @@ using namespace gl;
 #include <iostream>
 #include <sstream>
 #include <fstream>
+#include <set>
+#include <cerrno>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
 
 namespace utils {
 
@@ -133,6 +144,27 @@ std::string read_resource_path(int argc, char* argv[]) {
     return resource_path;
 }
 
+bool make_directory(std::string const& path) {
+#ifdef _WIN32
+    int result = _mkdir(path.c_str());
+#else
+    int result = mkdir(path.c_str(), 0755);
+#endif
+    // existing directory counts as success
+    return result == 0 || errno == EEXIST;
+}
+
+bool supports_extension(GLextension extension) {
+    // querying all extensions is expensive, only do it once per run
+    static std::set<GLextension> const extensions{glbinding::ContextInfo::extensions()};
+    return extensions.find(extension) != extensions.end();
+}
+
+bool supports_version(unsigned major, unsigned minor) {
+    static glbinding::Version const version{glbinding::ContextInfo::version()};
+    return version >= glbinding::Version(static_cast<unsigned char>(major), static_cast<unsigned char>(minor));
+}
+
 glm::fmat4 calculate_projection_matrix(float aspect) {
     // float aspect = float(width) / float(height);
     // base fov does not change
@@ -146,4 +178,27 @@ glm::fmat4 calculate_projection_matrix(float aspect) {
     return glm::perspective(fov_y, aspect, 0.1f, 100.0f);
 }
 
+void gaussian_linear_taps(unsigned radius, std::vector<float>& offsets, std::vector<float>& weights) {
+    // kernel covers about two standard deviations
+    float sigma = glm::max(float(radius) * 0.5f, 0.5f);
+    std::vector<float> discrete(radius + 1);
+    float sum = 0.0f;
+    for (unsigned i = 0; i <= radius; ++i) {
+        discrete[i] = glm::exp(-float(i * i) / (2.0f * sigma * sigma));
+        // all but the center are sampled on both sides
+        sum += (i == 0) ? discrete[i] : 2.0f * discrete[i];
+    }
+
+    offsets.assign(1, 0.0f);
+    weights.assign(1, discrete[0] / sum);
+    for (unsigned i = 1; i <= radius; i += 2) {
+        float weight_a = discrete[i] / sum;
+        float weight_b = (i + 1 <= radius) ? discrete[i + 1] / sum : 0.0f;
+        float weight = weight_a + weight_b;
+        // sampling between both texels with bilinear filtering returns their weighted sum
+        offsets.push_back((float(i) * weight_a + float(i + 1) * weight_b) / weight);
+        weights.push_back(weight);
+    }
+}
+
 }
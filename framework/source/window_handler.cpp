@@ -17,7 +17,10 @@
 
 #include "utils.hpp"
 #include "shader_loader.hpp"
+#include "allocation_counter.hpp"
+#include "frame_pacer.hpp"
 
+#include <cstdio>
 #include <cstdlib>
 #include <functional>
 #include <iostream>
@@ -140,19 +143,32 @@ void set_callback_object(GLFWwindow* window, Application* app) {
 
 
 // calculate fps and show in m_window title
-void show_fps(GLFWwindow* window) {
+void show_fps(GLFWwindow* window, std::size_t allocations, FramePacer const* pacer) {
     // variables for fps computation
     static double m_last_second_time;
     static unsigned m_frames_per_second;
+    static std::size_t m_allocations_per_second;
 
     ++m_frames_per_second;
+    m_allocations_per_second += allocations;
     double current_time = glfwGetTime();
     if (current_time - m_last_second_time >= 1.0) {
         std::string title{"OpenGL Framework - "};
         title += std::to_string(m_frames_per_second) + " fps";
+        if (allocation_counter::enabled()) {
+            title += ", " + std::to_string(m_allocations_per_second) + " allocations";
+        }
+        if (pacer != nullptr) {
+            // deviation of the frame time shows stutter the average hides
+            char frame_time[64];
+            std::snprintf(frame_time, sizeof(frame_time), ", %s %.2f +- %.2f ms", FramePacer::getModeName(pacer->getMode()),
+                          pacer->getMeanFrameTime(), pacer->getFrameTimeDeviation());
+            title += frame_time;
+        }
 
         glfwSetWindowTitle(window, title.c_str());
         m_frames_per_second = 0;
+        m_allocations_per_second = 0;
         m_last_second_time = current_time;
     }
 }
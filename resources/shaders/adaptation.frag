@@ -0,0 +1,17 @@
+#version 150
+
+out float out_Luminance;
+
+// log luminance, its last mip level is the average
+uniform sampler2D luminance_Texture;
+// adapted luminance of the last frame
+uniform sampler2D adapted_Texture;
+uniform float luminance_Level;
+// share of the difference closed this frame
+uniform float adaptation_Factor;
+
+void main() {
+    float average = exp(textureLod(luminance_Texture, vec2(0.5), luminance_Level).r);
+    float adapted = texelFetch(adapted_Texture, ivec2(0), 0).r;
+    out_Luminance = adapted + (average - adapted) * adaptation_Factor;
+}
@@ -0,0 +1,15 @@
+#version 150
+
+in vec2 pass_TexCoord;
+
+out vec4 out_Color;
+
+uniform sampler2D screen_Texture;
+// largest bloom level, half the size of the input
+uniform sampler2D bloom_Texture;
+uniform float bloom_Intensity;
+
+void main() {
+    vec4 color = texture(screen_Texture, pass_TexCoord);
+    out_Color = vec4(color.rgb + texture(bloom_Texture, pass_TexCoord).rgb * bloom_Intensity, color.a);
+}
@@ -0,0 +1,36 @@
+#version 150
+
+in vec2 pass_TexCoord;
+
+out vec4 out_Color;
+
+// level above, twice the size of the target
+uniform sampler2D screen_Texture;
+uniform vec2 texel_Size;
+
+#ifdef PREFILTER
+// luminance where the glow reaches full strength, faded in from half of it
+uniform float bloom_Threshold;
+
+vec3 prefilter(vec3 color) {
+    float brightness = max(color.r, max(color.g, color.b));
+    float knee = bloom_Threshold * 0.5;
+    float soft = clamp(brightness - bloom_Threshold + knee, 0.0, 2.0 * knee);
+    soft = soft * soft / (4.0 * knee + 0.0001);
+    float contribution = max(soft, brightness - bloom_Threshold) / max(brightness, 0.0001);
+    return color * contribution;
+}
+#endif
+
+void main() {
+    // four bilinear taps on texel corners average a 4x4 block, so thin bright lines do not flicker
+    vec3 color = texture(screen_Texture, pass_TexCoord + texel_Size * vec2(-1.0, -1.0)).rgb
+               + texture(screen_Texture, pass_TexCoord + texel_Size * vec2( 1.0, -1.0)).rgb
+               + texture(screen_Texture, pass_TexCoord + texel_Size * vec2(-1.0,  1.0)).rgb
+               + texture(screen_Texture, pass_TexCoord + texel_Size * vec2( 1.0,  1.0)).rgb;
+    color *= 0.25;
+#ifdef PREFILTER
+    color = prefilter(color);
+#endif
+    out_Color = vec4(color, 1.0);
+}
@@ -0,0 +1,23 @@
+#version 150
+
+in vec2 pass_TexCoord;
+
+out vec4 out_Color;
+
+// smaller level, added onto the bound one by blending
+uniform sampler2D screen_Texture;
+uniform vec2 texel_Size;
+
+void main() {
+    // 3x3 tent, weights 1 2 1 / 2 4 2 / 1 2 1
+    vec3 color = texture(screen_Texture, pass_TexCoord).rgb * 4.0;
+    color += (texture(screen_Texture, pass_TexCoord + texel_Size * vec2(-1.0, 0.0)).rgb
+            + texture(screen_Texture, pass_TexCoord + texel_Size * vec2( 1.0, 0.0)).rgb
+            + texture(screen_Texture, pass_TexCoord + texel_Size * vec2(0.0, -1.0)).rgb
+            + texture(screen_Texture, pass_TexCoord + texel_Size * vec2(0.0,  1.0)).rgb) * 2.0;
+    color += texture(screen_Texture, pass_TexCoord + texel_Size * vec2(-1.0, -1.0)).rgb
+           + texture(screen_Texture, pass_TexCoord + texel_Size * vec2( 1.0, -1.0)).rgb
+           + texture(screen_Texture, pass_TexCoord + texel_Size * vec2(-1.0,  1.0)).rgb
+           + texture(screen_Texture, pass_TexCoord + texel_Size * vec2( 1.0,  1.0)).rgb;
+    out_Color = vec4(color / 16.0, 1.0);
+}
@@ -0,0 +1,34 @@
+#version 150
+
+in vec2 pass_TexCoord;
+
+out vec4 out_Color;
+
+uniform sampler2D screen_Texture;
+// size of the input in texels
+uniform vec2 texture_Size;
+// (1, 0) for the horizontal, (0, 1) for the vertical pass
+uniform vec2 blur_Direction;
+
+#ifndef MAX_BLUR_TAPS
+#define MAX_BLUR_TAPS 16
+#endif
+
+// tap 0 is the center, the others are sampled on both sides
+// offsets lie between two texels, linear filtering blends both with the right ratio
+uniform int blur_Taps;
+uniform float blur_Offsets[MAX_BLUR_TAPS];
+uniform float blur_Weights[MAX_BLUR_TAPS];
+
+void main() {
+    vec2 texel_step = blur_Direction / texture_Size;
+
+    vec4 color = texture(screen_Texture, pass_TexCoord) * blur_Weights[0];
+    for (int i = 1; i < blur_Taps; ++i) {
+        vec2 offset = texel_step * blur_Offsets[i];
+        color += texture(screen_Texture, pass_TexCoord + offset) * blur_Weights[i];
+        color += texture(screen_Texture, pass_TexCoord - offset) * blur_Weights[i];
+    }
+
+    out_Color = color;
+}
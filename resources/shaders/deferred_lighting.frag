@@ -0,0 +1,48 @@
+#version 150
+// lights all covered pixels of the g-buffer at once, cost grows with pixels and lights, not overdraw
+
+in vec2 pass_TexCoord;
+
+out vec4 out_color;
+
+// albedo with ambient intensity in alpha, view space normal, depth
+uniform sampler2D AlbedoTexture;
+uniform sampler2D NormalTexture;
+uniform sampler2D DepthTexture;
+
+uniform mat4 InverseProjectionMatrix;
+// part of the g-buffer rendered this frame, below 1 at a lower resolution
+uniform vec2 TextureScale;
+uniform mat4 ViewMatrix;
+
+// point lights in world space, MAX_LIGHTS is injected by the application
+uniform int LightCount;
+uniform vec3 LightPositions[MAX_LIGHTS];
+uniform vec3 LightColors[MAX_LIGHTS];
+uniform float LightIntensities[MAX_LIGHTS];
+
+void main() {
+    vec2 tex_coord = pass_TexCoord * TextureScale;
+    float depth = texture(DepthTexture, tex_coord).r;
+    // nothing was drawn, the skybox stays visible
+    if (depth == 1.0) {
+        discard;
+    }
+    // view space position from the depth
+    vec4 position = InverseProjectionMatrix * vec4(vec3(pass_TexCoord, depth) * 2.0 - 1.0, 1.0);
+    vec3 vertex_position = position.xyz / position.w;
+
+    vec4 albedo = texture(AlbedoTexture, tex_coord);
+    vec3 normal_vector = normalize(texture(NormalTexture, tex_coord).xyz);
+    vec3 camera_direction_vector = normalize(-vertex_position);
+
+    vec3 color = albedo.a * albedo.rgb;
+    for (int i = 0; i < LightCount; ++i) {
+        vec3 light_direction_vector = normalize((ViewMatrix * vec4(LightPositions[i], 1.0)).xyz - vertex_position);
+        vec3 h = normalize(light_direction_vector + camera_direction_vector);
+
+        color += max(dot(normal_vector, light_direction_vector), 0.0) * albedo.rgb * LightIntensities[i] * LightColors[i];
+        color += pow(max(dot(h, normal_vector), 0.0), 64.0) * LightColors[i];
+    }
+    out_color = vec4(color, 1.0);
+}
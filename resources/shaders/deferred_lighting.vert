@@ -0,0 +1,10 @@
+#version 150
+// single triangle covering the screen, generated from gl_VertexID without attributes
+
+out vec2 pass_TexCoord;
+
+void main() {
+    vec2 corner = vec2(float((gl_VertexID << 1) & 2), float(gl_VertexID & 2));
+    pass_TexCoord = corner;
+    gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -0,0 +1,5 @@
+#version 150
+// depth pre-pass, only the depth written by the rasterizer is kept
+
+void main() {
+}
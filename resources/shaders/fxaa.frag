@@ -0,0 +1,125 @@
+#version 150
+
+in vec2 pass_TexCoord;
+
+out vec4 out_Color;
+
+uniform sampler2D screen_Texture;
+uniform vec2 texel_Size;
+
+// contrast below which a pixel is not treated as edge, relative and absolute
+const float edge_threshold = 0.125;
+const float edge_threshold_min = 0.0312;
+// steps searched along an edge in each direction
+const int search_steps = 8;
+
+float luma(vec3 color) {
+    return dot(color, vec3(0.299, 0.587, 0.114));
+}
+
+float luma_at(vec2 coord) {
+    return luma(texture(screen_Texture, coord).rgb);
+}
+
+void main() {
+    vec4 center_color = texture(screen_Texture, pass_TexCoord);
+    float center = luma(center_color.rgb);
+    float north = luma_at(pass_TexCoord + vec2(0.0, texel_Size.y));
+    float south = luma_at(pass_TexCoord - vec2(0.0, texel_Size.y));
+    float east = luma_at(pass_TexCoord + vec2(texel_Size.x, 0.0));
+    float west = luma_at(pass_TexCoord - vec2(texel_Size.x, 0.0));
+
+    float lowest = min(center, min(min(north, south), min(east, west)));
+    float highest = max(center, max(max(north, south), max(east, west)));
+    float contrast = highest - lowest;
+    if (contrast < max(edge_threshold_min, highest * edge_threshold)) {
+        out_Color = center_color;
+        return;
+    }
+
+    float north_east = luma_at(pass_TexCoord + texel_Size);
+    float south_west = luma_at(pass_TexCoord - texel_Size);
+    float north_west = luma_at(pass_TexCoord + vec2(-texel_Size.x, texel_Size.y));
+    float south_east = luma_at(pass_TexCoord + vec2(texel_Size.x, -texel_Size.y));
+
+    // blend strength from the difference to the 3x3 average, sharper features blend more
+    float average = (2.0 * (north + south + east + west) + north_east + north_west + south_east + south_west) / 12.0;
+    float subpixel = clamp(abs(average - center) / contrast, 0.0, 1.0);
+    subpixel = smoothstep(0.0, 1.0, subpixel);
+    subpixel = subpixel * subpixel * 0.75;
+
+    // edge orientation from second derivatives across both axes
+    float horizontal = abs(north + south - 2.0 * center) * 2.0
+                     + abs(north_east + south_east - 2.0 * east)
+                     + abs(north_west + south_west - 2.0 * west);
+    float vertical = abs(east + west - 2.0 * center) * 2.0
+                   + abs(north_east + north_west - 2.0 * north)
+                   + abs(south_east + south_west - 2.0 * south);
+    bool is_horizontal = horizontal >= vertical;
+
+    // step towards the neighbour with the stronger gradient
+    float positive = is_horizontal ? north : east;
+    float negative = is_horizontal ? south : west;
+    float gradient_positive = abs(positive - center);
+    float gradient_negative = abs(negative - center);
+    float step_length = is_horizontal ? texel_Size.y : texel_Size.x;
+    float opposite = positive;
+    float gradient = gradient_positive;
+    if (gradient_negative > gradient_positive) {
+        step_length = -step_length;
+        opposite = negative;
+        gradient = gradient_negative;
+    }
+
+    // walk along the edge, halfway between the center and the opposite row
+    vec2 edge_coord = pass_TexCoord;
+    vec2 edge_step = is_horizontal ? vec2(texel_Size.x, 0.0) : vec2(0.0, texel_Size.y);
+    if (is_horizontal) {
+        edge_coord.y += step_length * 0.5;
+    }
+    else {
+        edge_coord.x += step_length * 0.5;
+    }
+    float edge_luma = (center + opposite) * 0.5;
+    float gradient_threshold = gradient * 0.25;
+
+    vec2 coord_positive = edge_coord + edge_step;
+    vec2 coord_negative = edge_coord - edge_step;
+    float delta_positive = luma_at(coord_positive) - edge_luma;
+    float delta_negative = luma_at(coord_negative) - edge_luma;
+    bool done_positive = abs(delta_positive) >= gradient_threshold;
+    bool done_negative = abs(delta_negative) >= gradient_threshold;
+    for (int i = 1; i < search_steps && !(done_positive && done_negative); ++i) {
+        if (!done_positive) {
+            coord_positive += edge_step;
+            delta_positive = luma_at(coord_positive) - edge_luma;
+            done_positive = abs(delta_positive) >= gradient_threshold;
+        }
+        if (!done_negative) {
+            coord_negative -= edge_step;
+            delta_negative = luma_at(coord_negative) - edge_luma;
+            done_negative = abs(delta_negative) >= gradient_threshold;
+        }
+    }
+
+    // the nearer end of the edge decides how far this pixel is blended across it
+    float distance_positive = is_horizontal ? coord_positive.x - pass_TexCoord.x : coord_positive.y - pass_TexCoord.y;
+    float distance_negative = is_horizontal ? pass_TexCoord.x - coord_negative.x : pass_TexCoord.y - coord_negative.y;
+    bool positive_nearer = distance_positive <= distance_negative;
+    float nearest = min(distance_positive, distance_negative);
+    float span = distance_positive + distance_negative;
+    // only blend if the center lies on the side of the edge the end moves towards
+    bool center_below = center - edge_luma < 0.0;
+    bool end_below = (positive_nearer ? delta_positive : delta_negative) < 0.0;
+    float edge_blend = center_below != end_below ? 0.5 - nearest / span : 0.0;
+
+    float blend = max(edge_blend, subpixel);
+    vec2 coord = pass_TexCoord;
+    if (is_horizontal) {
+        coord.y += blend * step_length;
+    }
+    else {
+        coord.x += blend * step_length;
+    }
+    out_Color = vec4(texture(screen_Texture, coord).rgb, center_color.a);
+}
@@ -0,0 +1,14 @@
+#version 150
+
+in vec2 pass_TexCoord;
+
+out float out_Luminance;
+
+uniform sampler2D screen_Texture;
+
+void main() {
+    vec3 color = texture(screen_Texture, pass_TexCoord).rgb;
+    float luminance = dot(color, vec3(0.2126, 0.7152, 0.0722));
+    // averaging logarithms gives the geometric mean, bright spots do not dominate
+    out_Luminance = log(max(luminance, 0.0001));
+}
@@ -1,13 +1,53 @@
 #version 150
-#extension GL_ARB_explicit_attrib_location : require
-// glVertexAttribPointer mapped positions to first
-layout(location = 0) in vec3 in_Position;
+// rings are generated from gl_VertexID, one instance per orbit
+
+// two texels per orbit, in radians
+// semi-major axis, eccentricity, inclination, longitude of ascending node
+// argument of periapsis, center of the orbit
+uniform samplerBuffer OrbitElements;
+// vertices per instance are MaxSegments + 1, surplus vertices collapse onto the last one
+uniform int MaxSegments;
+uniform int MinSegments;
+// target length of one segment on screen
+uniform float PixelsPerSegment;
+uniform float ViewportHeight;
 
 //Matrix Uniforms uploaded with glUniform*
-uniform mat4 OrbitMatrix;
 uniform mat4 ViewMatrix;
 uniform mat4 ProjectionMatrix;
 
+const float PI = 3.14159265358979323846;
+
 void main() {
-    gl_Position = (ProjectionMatrix  * ViewMatrix * OrbitMatrix) * vec4(in_Position, 1.0);
+    vec4 elements = texelFetch(OrbitElements, 2 * gl_InstanceID);
+    vec4 placement = texelFetch(OrbitElements, 2 * gl_InstanceID + 1);
+    vec3 focus = placement.yzw;
+    float axis = elements.x;
+    float eccentricity = elements.y;
+
+    // projected radius where the ring comes closest to the camera
+    vec3 center = (ViewMatrix * vec4(focus, 1.0)).xyz;
+    float nearest = max(length(center) - axis, 0.1);
+    float pixels = axis * ProjectionMatrix[1][1] * 0.5 * ViewportHeight / nearest;
+    int segments = int(clamp(2.0 * PI * pixels / PixelsPerSegment, float(MinSegments), float(MaxSegments)));
+
+    // uniform steps in eccentric anomaly, origin in the focus
+    float anomaly = 2.0 * PI * float(min(gl_VertexID, segments)) / float(segments);
+    vec3 position = vec3(axis * (cos(anomaly) - eccentricity),
+                         0.0,
+                         axis * sqrt(1.0 - eccentricity * eccentricity) * sin(anomaly));
+
+    // same rotations as kepler::propagate
+    // periapsis within the plane, tilt around the line of nodes, then turn the node around the pole
+    float cp = cos(placement.x);
+    float sp = sin(placement.x);
+    position = vec3(cp * position.x + sp * position.z, 0.0, -sp * position.x + cp * position.z);
+    float ci = cos(elements.z);
+    float si = sin(elements.z);
+    position = vec3(position.x, -si * position.z, ci * position.z);
+    float cn = cos(elements.w);
+    float sn = sin(elements.w);
+    position = vec3(cn * position.x + sn * position.z, position.y, -sn * position.x + cn * position.z);
+
+    gl_Position = (ProjectionMatrix * ViewMatrix) * vec4(focus + position, 1.0);
 }
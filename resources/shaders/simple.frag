@@ -1,4 +1,5 @@
 #version 150
+#extension GL_ARB_explicit_attrib_location : require
 
 // inputs
 in vec3 pass_Normal;
@@ -6,20 +7,30 @@ in vec3 pass_Vertex_Position;
 in vec3 pass_Camera_Position;
 in vec2 pass_TexCoord;
 in mat4 pass_ViewMatrix;
+flat in vec3 pass_Ambient;
 
+#ifdef GBUFFER
+// material of the deferred path, lit in deferred_lighting.frag
+layout(location = 0) out vec4 out_albedo;
+layout(location = 1) out vec4 out_normal;
+#else
 // outout: color of position
-out vec4 out_color;
+layout(location = 0) out vec4 out_color;
+#endif
 
 // uploaded uniforms
-uniform vec3 planet_color;
 uniform vec3 light_position;
 uniform vec3 light_color;
 uniform float light_intensity;
-uniform vec3 ambient_intensity;
 uniform sampler2D planet_texture;
 
 void main() {
   vec3 normal_vector = normalize(pass_Normal);
+#ifdef GBUFFER
+  // ambient intensity in alpha, normal in view space
+  out_albedo = vec4(texture(planet_texture, pass_TexCoord).rgb, pass_Ambient.r);
+  out_normal = vec4(normal_vector, 0.0);
+#else
   // create direction vectors (pointing form the vertex to the light / camera)
   vec3 light_direction_vector = normalize((pass_ViewMatrix * vec4(light_position, 1.0) - vec4(pass_Vertex_Position, 1.0)).xyz);
   vec3 camera_direction_vector = normalize((pass_ViewMatrix * vec4(pass_Camera_Position, 1.0) - vec4(pass_Vertex_Position, 1.0)).xyz);
@@ -30,11 +41,12 @@ void main() {
   // calculate color current
   vec4 texture_color = texture(planet_texture, pass_TexCoord);
 
-  vec3 ambient_color = ambient_intensity * texture_color.rgb;
+  vec3 ambient_color = pass_Ambient * texture_color.rgb;
 
   vec3 diffuse_color = max(dot(normal_vector, light_direction_vector), 0) * texture_color.rgb * light_intensity * light_color;
 
   vec3 specular_color = pow(max(dot(h, normal_vector), 0), 64.0) * light_color;
 
   out_color = vec4(ambient_color + diffuse_color + specular_color, 1.0);
+#endif
 }
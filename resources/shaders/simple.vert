@@ -4,21 +4,36 @@
 layout(location = 0) in vec3 in_Position;
 layout(location = 1) in vec3 in_Normal;
 layout(location = 2) in vec2 in_TexCoord;
+// base instance of the draw command, selects the body
+layout(location = 3) in int in_DrawIndex;
 
 //Matrix Uniforms as specified with glUniformMatrix4fv
-uniform mat4 ModelMatrix;
 uniform mat4 ViewMatrix;
 uniform mat4 ProjectionMatrix;
-uniform mat4 NormalMatrix;
+
+// nine texels per body: model matrix, normal matrix and ambient intensity
+uniform samplerBuffer BodyData;
+// added to the draw index when commands are drawn one by one
+uniform int DrawOffset;
 
 out mat4 pass_ViewMatrix;
 out vec3 pass_Normal;
 out vec3 pass_Vertex_Position;
 out vec3 pass_Camera_Position;
 out vec2 pass_TexCoord;
+flat out vec3 pass_Ambient;
+// depth pre-pass and shading pass must produce equal depth
+invariant gl_Position;
 
 void main(void)
 {
+    int body = 9 * (DrawOffset + in_DrawIndex);
+    mat4 ModelMatrix = mat4(texelFetch(BodyData, body), texelFetch(BodyData, body + 1),
+                            texelFetch(BodyData, body + 2), texelFetch(BodyData, body + 3));
+    mat4 NormalMatrix = mat4(texelFetch(BodyData, body + 4), texelFetch(BodyData, body + 5),
+                             texelFetch(BodyData, body + 6), texelFetch(BodyData, body + 7));
+    pass_Ambient = texelFetch(BodyData, body + 8).rgb;
+
     gl_Position = (ProjectionMatrix  * ViewMatrix * ModelMatrix) * vec4(in_Position, 1.0);
 
     // pass the view matrix
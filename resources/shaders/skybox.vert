@@ -18,5 +18,6 @@ void main() {
     mat3 inverseModView = transpose(mat3(ViewMatrix));
     vec3 unprojected = (inverseProj * in_Position).xyz;
     camDirection = inverseModView * unprojected;
-    gl_Position = in_Position;
+    // on the far plane, drawn last it only covers pixels nothing else was drawn to
+    gl_Position = in_Position.xyww;
 }
\ No newline at end of file
@@ -0,0 +1,22 @@
+#version 150
+
+in vec2 pass_TexCoord;
+
+out vec4 out_Color;
+
+uniform sampler2D screen_Texture;
+// single texel holding the adapted average luminance
+uniform sampler2D adapted_Texture;
+// manual exposure compensation
+uniform float exposure_Scale;
+
+// luminance the average is mapped to
+const float key_value = 0.18;
+
+void main() {
+    vec3 color = texture(screen_Texture, pass_TexCoord).rgb;
+    float adapted = max(texelFetch(adapted_Texture, ivec2(0), 0).r, 0.0001);
+    color *= key_value / adapted * exposure_Scale;
+    // reinhard, compresses highlights smoothly into [0, 1)
+    out_Color = vec4(color / (1.0 + color), 1.0);
+}